@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_ASTAR
+
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include "common.h"
+#include "domain.h"
+#include "searchState.h"
+#include "perimeterDB.h"
+#include "searchResult.h"
+#include <vector>
+
+// A node in the A* search graph.
+struct AStarNode
+{
+  SearchState   state;
+  AStarNode *   parent;
+  AStarNode *   hashNext;			// next node in the same hash bucket
+  Operator      op;						// operator applied to the parent to get here
+  int           heuristic;
+  bool          closed;
+};
+
+// Hands out nodes from large blocks that are never moved or freed one at a time.
+// reset() makes all the nodes available again, but keeps the memory.
+class AStarArena
+{
+private:
+  static const int BLOCK_SIZE = 1<<16;
+  std::vector<AStarNode*> blocks;
+  int numBlocks;		// blocks in use
+  int blockUsed;		// nodes used in the last block in use
+
+public:
+  AStarArena() : numBlocks(0), blockUsed(BLOCK_SIZE) {}
+  ~AStarArena();
+  AStarNode * alloc();
+  void reset() { numBlocks = 0; blockUsed = BLOCK_SIZE; }
+  long long size() const { return (long long)blocks.size()*BLOCK_SIZE; }
+};
+
+// A* with an open list of buckets indexed by f-value (f < MAX_COST),
+// and one hash table (keyed on Hash::value) for both the open and closed nodes.
+// Nodes are reopened if they are reached again with a lower cost,
+// so the solution is optimal with an admissible heuristic.
+class AStar
+{
+public:
+  long long generationCount;
+  long long expansionCount;
+  SearchState m_goal;
+#ifdef USE_PERIMETER_DB
+  const PerimeterDb & perimeterDb;
+#endif
+
+private:
+  AStarArena arena;
+  std::vector<AStarNode*> open[MAX_COST];
+  int minF;		// no open node has a lower f-value
+  std::vector<AStarNode*> hashTable;
+  long long numNodes;
+  SearchResult result;
+
+public:
+#ifdef USE_PERIMETER_DB
+  AStar(const PerimeterDb & _perimeterDb) : perimeterDb(_perimeterDb) { _init(); }
+#else
+  AStar() { _init(); }
+#endif
+
+  // Main search function
+  // returns the cost of the solution, or -1 if there is none.
+  int search(const SearchState & start, const SearchState & goal);
+  long long getNodesGenerated() { return generationCount; }
+  long long getNodesExpanded() const { return expansionCount; }
+  long long getNodesStored() const { return numNodes; }
+  // A* searches in a single pass
+  int getIterations() const { return 1; }
+  // The outcome of the last search, including the path from the start to the goal
+  const SearchResult & getResult() const { return result; }
+  const std::vector<Operator> & getPath() const { return result.path; }
+
+private:
+  void _init();
+  void reset();
+
+  // Same as IDA::getHeuristic, without the trans table
+  int getHeuristic(const SearchState & state) const;
+
+  // Returns the node for the state, or NULL if it was never generated
+  AStarNode * lookup(const SearchState & state) const;
+  void insert(AStarNode * node);
+  void growHashTable();
+
+  void push(AStarNode * node);
+  // returns NULL when the open list is empty
+  AStarNode * pop();
+
+  void buildPath(const AStarNode * goal);
+};
+
+#include "astar.hpp"
+
+#endif	// ASTAR_H
+#endif	// USE_ASTAR
@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#include <stdlib.h>
+#include <algorithm>
+
+////////////////////////////////
+// AStarArena //////////////////
+////////////////////////////////
+
+AStarArena::~AStarArena()
+{
+  for( unsigned int i=0; i<blocks.size(); i++ )
+  {
+    free(blocks[i]);
+  }
+}
+
+// The nodes are not constructed.  The caller sets every field.
+inline AStarNode * AStarArena::alloc()
+{
+  if( blockUsed == BLOCK_SIZE )
+  {
+    if( numBlocks == (int)blocks.size() )
+    {
+      AStarNode * block = (AStarNode*)malloc(sizeof(AStarNode)*BLOCK_SIZE);
+      if( !block )
+      {
+        LOG_ERROR("AStar out of memory after %lli nodes\n", size());
+        exit(1);
+      }
+      blocks.push_back(block);
+    }
+    numBlocks++;
+    blockUsed = 0;
+  }
+  return &blocks[numBlocks-1][blockUsed++];
+}
+
+////////////////////////////////
+// AStar ///////////////////////
+////////////////////////////////
+
+inline void AStar::_init()
+{
+  generationCount = 0;
+  expansionCount = 0;
+  numNodes = 0;
+  minF = MAX_COST;
+  hashTable.resize(1<<16, (AStarNode*)NULL);
+}
+
+inline void AStar::reset()
+{
+  arena.reset();
+  for( int f=0; f<MAX_COST; f++ )
+  {
+    open[f].clear();
+  }
+  minF = MAX_COST;
+  std::fill(hashTable.begin(), hashTable.end(), (AStarNode*)NULL);
+  numNodes = 0;
+  result.clear();
+}
+
+inline int AStar::getHeuristic(const SearchState & state) const
+{
+  int returnVal = 0;
+#ifdef USE_HEURISTIC
+  returnVal = state.incHeuristic.value;
+#endif
+#ifdef USE_PERIMETER_DB
+  const int perimeterHeuristicVal = this->perimeterDb.getHeuristic(state.state, state.hash);
+  returnVal = std::max( returnVal, perimeterHeuristicVal );
+#endif
+  return returnVal;
+}
+
+inline AStarNode * AStar::lookup(const SearchState & state) const
+{
+  AStarNode * node = hashTable[state.hash.value & (hashTable.size()-1)];
+  while( node && !(node->state == state) )
+  {
+    node = node->hashNext;
+  }
+  return node;
+}
+
+inline void AStar::insert(AStarNode * node)
+{
+  if( numNodes >= (long long)hashTable.size() )
+  {
+    growHashTable();
+  }
+  AStarNode * & bucket = hashTable[node->state.hash.value & (hashTable.size()-1)];
+  node->hashNext = bucket;
+  bucket = node;
+  numNodes++;
+}
+
+// Doubles the number of buckets
+inline void AStar::growHashTable()
+{
+  std::vector<AStarNode*> oldTable(hashTable.size()*2, (AStarNode*)NULL);
+  oldTable.swap(hashTable);
+  for( unsigned int i=0; i<oldTable.size(); i++ )
+  {
+    AStarNode * node = oldTable[i];
+    while( node )
+    {
+      AStarNode * next = node->hashNext;
+      AStarNode * & bucket = hashTable[node->state.hash.value & (hashTable.size()-1)];
+      node->hashNext = bucket;
+      bucket = node;
+      node = next;
+    }
+  }
+}
+
+inline void AStar::push(AStarNode * node)
+{
+  const int f = node->state.cost + node->heuristic;
+  open[f].push_back(node);
+  minF = std::min(minF, f);
+}
+
+// Nodes are taken last in, first out within an f-value, which prefers deeper nodes.
+// A node that was pushed again with a lower cost leaves a stale entry behind,
+// which is skipped because the node is closed by then.
+inline AStarNode * AStar::pop()
+{
+  while( minF < MAX_COST )
+  {
+    std::vector<AStarNode*> & bucket = open[minF];
+    while( !bucket.empty() )
+    {
+      AStarNode * node = bucket.back();
+      bucket.pop_back();
+      if( !node->closed )
+      {
+        return node;
+      }
+    }
+    minF++;
+  }
+  return NULL;
+}
+
+inline void AStar::buildPath(const AStarNode * goal)
+{
+  result.path.clear();
+  for( const AStarNode * node = goal; node->parent; node = node->parent )
+  {
+    result.path.push_back(node->op);
+  }
+  std::reverse(result.path.begin(), result.path.end());
+}
+
+inline int AStar::search(const SearchState & start, const SearchState & goal)
+{
+  generationCount = 0;
+  expansionCount = 0;
+  m_goal = goal;
+  reset();
+  const double startTime = getWallTime();
+
+  AStarNode * root = arena.alloc();
+  root->state = start;
+  root->parent = NULL;
+  root->op = NO_OP;
+  root->heuristic = getHeuristic(start);
+  root->closed = false;
+  generationCount++;
+  insert(root);
+  if( root->state.cost + root->heuristic < MAX_COST )
+  {
+    push(root);
+  }
+
+  int solutionCost = -1;
+  AStarNode * node;
+  while( (node = pop()) )
+  {
+    node->closed = true;
+    if( node->state == m_goal )
+    {
+      solutionCost = node->state.cost;
+      buildPath(node);
+      break;
+    }
+
+    expansionCount++;
+    SearchState state = node->state;
+    const OpList opList = state.findSuccessorOperators();
+    for( int i=0; i<opList.length; i++ )
+    {
+      state.apply( opList.ops[i] );
+      generationCount++;
+
+      AStarNode * child = lookup(state);
+      if( !child )
+      {
+        child = arena.alloc();
+        child->state = state;
+        child->heuristic = getHeuristic(state);
+        insert(child);
+      }
+      else if( state.cost < child->state.cost )
+      {	// Found a cheaper path.  Reopen the node if it was closed.
+        child->state = state;
+      }
+      else
+      {	// Already reached at least as cheaply
+        state.unapply( opList.ops[i] );
+        continue;
+      }
+      child->parent = node;
+      child->op = opList.ops[i];
+      child->closed = false;
+#ifdef USE_BPMX
+      // pathmax: the child can't be closer to the goal than the parent, less the edge cost
+      child->heuristic = std::max(child->heuristic, node->heuristic - (state.cost - node->state.cost));
+#endif
+      if( state.cost + child->heuristic < MAX_COST )
+      {
+        push(child);
+      }
+      state.unapply( opList.ops[i] );
+    }
+  }
+
+  // A single entry stands for the whole search
+  const double time = getWallTime() - startTime;
+  result.addIteration( solutionCost, generationCount, time, -1.0 );
+  result.nodesGenerated = generationCount;
+  result.time = time;
+  result.solutionLength = solutionCost;
+  return solutionCost;
+}
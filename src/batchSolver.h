@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_BATCH_SOLVER
+
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include "common.h"
+#include "domain.h"
+#include "searchState.h"
+#include "search.h"
+#include "searchResult.h"
+#include <pthread.h>
+#include <vector>
+
+// Solves many independent instances at the same time.
+// Each worker thread has its own IDA object (and so its own trans table),
+// and takes the next unsolved instance whenever it finishes one.
+// The PerimeterDb is shared by all workers and is only read from.
+class BatchSolver
+{
+private:
+  struct WorkerArg
+  {
+    BatchSolver * self;
+    int           id;
+  };
+
+  const int numThreads;
+  std::vector<IDA*> workers;
+
+  // The current batch
+  const std::vector<SearchState> * startStates;
+  SearchState goal;
+  std::vector<SearchResult> * results;
+  volatile int nextInstance;
+
+public:
+#ifdef USE_PERIMETER_DB
+  BatchSolver(const PerimeterDb & perimeterDb, const int _numThreads = NUM_THREADS);
+#else
+  BatchSolver(const int _numThreads = NUM_THREADS);
+#endif
+  ~BatchSolver();
+
+  // Solves every start state.  results[i] belongs to startStates[i].
+  void solve(const std::vector<SearchState> & startStates, const SearchState & goal, std::vector<SearchResult> & results);
+  int getNumThreads() const { return numThreads; }
+
+private:
+  static void * workerMain( void * arg );
+  void runWorker( const int id );
+};
+
+#include "batchSolver.hpp"
+
+#endif	// BATCH_SOLVER_H
+#endif	// USE_BATCH_SOLVER
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+////////////////////////////////
+// Batch solver ////////////////
+////////////////////////////////
+
+#ifdef USE_PERIMETER_DB
+BatchSolver::BatchSolver(const PerimeterDb & perimeterDb, const int _numThreads)
+#else
+BatchSolver::BatchSolver(const int _numThreads)
+#endif
+: numThreads(_numThreads), startStates(NULL), results(NULL), nextInstance(0)
+{
+  for( int i=0; i<numThreads; i++ )
+  {
+#ifdef USE_PERIMETER_DB
+    workers.push_back(new IDA(perimeterDb));
+#else
+    workers.push_back(new IDA());
+#endif
+  }
+}
+
+BatchSolver::~BatchSolver()
+{
+  for( int i=0; i<numThreads; i++ )
+  {
+    delete workers[i];
+  }
+}
+
+void * BatchSolver::workerMain( void * arg )
+{
+  WorkerArg * workerArg = (WorkerArg*)arg;
+  workerArg->self->runWorker(workerArg->id);
+  return NULL;
+}
+
+inline void BatchSolver::runWorker( const int id )
+{
+  IDA & ida = *workers[id];
+  while( true )
+  {
+    const int i = __sync_fetch_and_add(&nextInstance, 1);
+    if( i >= (int)startStates->size() )
+    {
+      break;
+    }
+
+    const double startTime = getWallTime();
+    ida.search((*startStates)[i], goal);
+    SearchResult & result = (*results)[i];
+    result = ida.getResult();
+    // clock() counts every thread in the process, so use the wall clock instead
+    result.time = getWallTime() - startTime;
+  }
+}
+
+inline void BatchSolver::solve(const std::vector<SearchState> & _startStates, const SearchState & _goal, std::vector<SearchResult> & _results)
+{
+  startStates = &_startStates;
+  goal = _goal;
+  results = &_results;
+  results->resize(startStates->size());
+  nextInstance = 0;
+
+  std::vector<pthread_t> threads(numThreads);
+  std::vector<WorkerArg> workerArgs(numThreads);
+  for( int i=0; i<numThreads; i++ )
+  {
+    workerArgs[i].self = this;
+    workerArgs[i].id = i;
+    if( pthread_create(&threads[i], NULL, workerMain, &workerArgs[i]) != 0 )
+    {
+      LOG_ERROR("Could not create worker thread %i\n", i);
+      exit(1);
+    }
+  }
+  for( int i=0; i<numThreads; i++ )
+  {
+    pthread_join(threads[i], NULL);
+  }
+
+  startStates = NULL;
+  results = NULL;
+}
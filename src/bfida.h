@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_BFIDA
+
+#ifndef BFIDA_H
+#define BFIDA_H
+
+#include "common.h"
+#include "domain.h"
+#include "searchState.h"
+#include "perimeterDB.h"
+#include "searchResult.h"
+#include <stdio.h>
+#include <vector>
+
+// Orders states by their bytes, so that duplicates end up next to each other.
+struct StateLess
+{
+  bool operator()( const State & a, const State & b ) const { return memcmp(&a, &b, sizeof(State)) < 0; }
+};
+
+// A temporary file of states that is only ever written or read from start to end.
+// It is deleted when closed.
+class StateFile
+{
+private:
+  FILE * file;
+  long long count;
+
+public:
+  StateFile();
+  ~StateFile();
+  void write( const State & state );
+  // returns false at the end of the file
+  bool read( State & state );
+  // Start reading from the beginning
+  void rewind();
+  long long size() const { return count; }
+};
+
+// Breadth-first iterative deepening A* (BFIDA*).
+// Every iteration is a breadth-first search that only keeps nodes with f <= cost limit.
+// Each layer (all nodes with the same g) is stored as a sorted file on disk.
+// Duplicates are removed after a layer is generated (delayed duplicate detection):
+// the children are sorted in memory in runs of BFIDA_RUN_SIZE states,
+// and the runs are merged while skipping states that are in the two previous layers.
+// Only unit cost operators and undirected state spaces are supported,
+// so a duplicate can't be further back than two layers.
+class BFIDA
+{
+public:
+  long long generationCount;
+  SearchState m_goal;
+#ifdef USE_PERIMETER_DB
+  const PerimeterDb & perimeterDb;
+#endif
+
+private:
+  int numIterations;
+  int minOverflow;			// smallest f-value over the cost limit on this iteration
+  long long maxLayerSize;
+  std::vector<State> buffer;
+  std::vector<int> runLevels;	// for each run, how many times its states have been merged
+  SearchResult result;
+
+public:
+#ifdef USE_PERIMETER_DB
+  BFIDA(const PerimeterDb & _perimeterDb) : perimeterDb(_perimeterDb) { _init(); }
+#else
+  BFIDA() { _init(); }
+#endif
+
+  // Main search function
+  // returns the cost of the solution, or -1 if there is none.
+  int search(const SearchState & start, const SearchState & goal);
+  long long getNodesGenerated() { return generationCount; }
+  int getIterations() const { return numIterations; }
+  long long getMaxLayerSize() const { return maxLayerSize; }
+  // The outcome of the last search. Only the frontier is kept, so the path stays empty.
+  const SearchResult & getResult() const { return result; }
+
+private:
+  void _init();
+
+  // Same as IDA::getHeuristic, without the trans table
+  int getHeuristic(const SearchState & state) const;
+
+  // returns the solution cost, or -1 if there is no solution within the cost limit
+  int searchIteration( const SearchState & start, const int & costLimit );
+  // Sorts the buffer, removes duplicates and writes it to a new run
+  void writeRun( std::vector<StateFile*> & runs );
+  // Replaces the last count runs with one run of their states
+  void mergeTail( std::vector<StateFile*> & runs, const int & count );
+  // Merges the runs into the next layer, BFIDA_MERGE_FAN_IN at a time,
+  // leaving out duplicates and states in the current or previous layer.
+  void mergeRuns( std::vector<StateFile*> & runs, StateFile * current, StateFile * previous, StateFile * next );
+  // Merges the runs into one file, and deletes them.
+  // States in current or previous (if not NULL) are left out.
+  void mergeFiles( std::vector<StateFile*> & runs, StateFile * current, StateFile * previous, StateFile * next );
+};
+
+#include "bfida.hpp"
+
+#endif	// BFIDA_H
+#endif	// USE_BFIDA
@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#include <stdlib.h>
+#include <algorithm>
+#include <queue>
+
+////////////////////////////////
+// StateFile ///////////////////
+////////////////////////////////
+
+StateFile::StateFile() : count(0)
+{
+  file = tmpfile();
+  if( !file )
+  {
+    LOG_ERROR("Could not create a temporary file for BFIDA\n");
+    exit(1);
+  }
+  // Full buffering, since the access is always sequential
+  setvbuf(file, NULL, _IOFBF, BFIDA_FILE_BUFFER);
+}
+
+StateFile::~StateFile()
+{
+  fclose(file);
+}
+
+inline void StateFile::write( const State & state )
+{
+  if( fwrite(&state, sizeof(State), 1, file) != 1 )
+  {
+    LOG_ERROR("Could not write to a BFIDA layer file\n");
+    exit(1);
+  }
+  count++;
+}
+
+inline bool StateFile::read( State & state )
+{
+  return fread(&state, sizeof(State), 1, file) == 1;
+}
+
+inline void StateFile::rewind()
+{
+  fflush(file);
+  ::rewind(file);
+}
+
+////////////////////////////////
+// BFIDA ///////////////////////
+////////////////////////////////
+
+inline void BFIDA::_init()
+{
+  generationCount = 0;
+  numIterations = 0;
+  minOverflow = MAX_COST;
+  maxLayerSize = 0;
+  buffer.reserve(BFIDA_RUN_SIZE);
+}
+
+inline int BFIDA::getHeuristic(const SearchState & state) const
+{
+  int returnVal = 0;
+#ifdef USE_HEURISTIC
+  returnVal = state.incHeuristic.value;
+#endif
+#ifdef USE_PERIMETER_DB
+  const int perimeterHeuristicVal = this->perimeterDb.getHeuristic(state.state, state.hash);
+  returnVal = std::max( returnVal, perimeterHeuristicVal );
+#endif
+  return returnVal;
+}
+
+inline void BFIDA::writeRun( std::vector<StateFile*> & runs )
+{
+  std::sort(buffer.begin(), buffer.end(), StateLess());
+  StateFile * run = new StateFile();
+  for( unsigned int i=0; i<buffer.size(); i++ )
+  {
+    if( i == 0 || !(buffer[i] == buffer[i-1]) )
+    {
+      run->write(buffer[i]);
+    }
+  }
+  run->rewind();
+  runs.push_back(run);
+  runLevels.push_back(0);
+  buffer.clear();
+
+  // Like a counter in base BFIDA_MERGE_FAN_IN: once there are that many runs
+  // of one level, they become a single run of the next level.
+  // The levels only go down along runs, so those runs are always the last ones.
+  while( (int)runs.size() >= BFIDA_MERGE_FAN_IN
+    && runLevels[runs.size()-BFIDA_MERGE_FAN_IN] == runLevels.back() )
+  {
+    const int level = runLevels.back();
+    mergeTail( runs, BFIDA_MERGE_FAN_IN );
+    runLevels.resize( runs.size() );
+    runLevels.back() = level+1;
+  }
+}
+
+inline void BFIDA::mergeTail( std::vector<StateFile*> & runs, const int & count )
+{
+  std::vector<StateFile*> tail( runs.end()-count, runs.end() );
+  runs.resize( runs.size()-count );
+  StateFile * merged = new StateFile();
+  mergeFiles(tail, NULL, NULL, merged);
+  merged->rewind();
+  runs.push_back(merged);
+}
+
+// A state read from one of the runs during the merge
+struct RunHead
+{
+  State         state;
+  int           run;
+};
+
+struct RunHeadGreater
+{
+  bool operator()( const RunHead & a, const RunHead & b ) const { return StateLess()(b.state, a.state); }
+};
+
+inline void BFIDA::mergeRuns( std::vector<StateFile*> & runs, StateFile * current, StateFile * previous, StateFile * next )
+{
+  while( (int)runs.size() > BFIDA_MERGE_FAN_IN )
+  {
+    mergeTail( runs, BFIDA_MERGE_FAN_IN );
+  }
+  runLevels.clear();
+  mergeFiles(runs, current, previous, next);
+}
+
+inline void BFIDA::mergeFiles( std::vector<StateFile*> & runs, StateFile * current, StateFile * previous, StateFile * next )
+{
+  std::priority_queue<RunHead, std::vector<RunHead>, RunHeadGreater> heads;
+  for( unsigned int i=0; i<runs.size(); i++ )
+  {
+    RunHead head;
+    head.run = i;
+    if( runs[i]->read(head.state) )
+    {
+      heads.push(head);
+    }
+  }
+
+  // The two previous layers are sorted too, so they are streamed alongside
+  StateFile * layers[2] = { current, previous };
+  State layerState[2];
+  bool layerValid[2];
+  for( int l=0; l<2; l++ )
+  {
+    layerValid[l] = false;
+    if( layers[l] )
+    {
+      layers[l]->rewind();
+      layerValid[l] = layers[l]->read(layerState[l]);
+    }
+  }
+
+  State last;
+  bool first = true;
+  while( !heads.empty() )
+  {
+    RunHead head = heads.top();
+    heads.pop();
+    const State state = head.state;
+    if( runs[head.run]->read(head.state) )
+    {
+      heads.push(head);
+    }
+
+    // duplicate within the new layer
+    if( !first && state == last )
+    {
+      continue;
+    }
+    first = false;
+    last = state;
+
+    // duplicate of the previous layers
+    bool duplicate = false;
+    for( int l=0; l<2; l++ )
+    {
+      while( layerValid[l] && StateLess()(layerState[l], state) )
+      {
+        layerValid[l] = layers[l]->read(layerState[l]);
+      }
+      if( layerValid[l] && layerState[l] == state )
+      {
+        duplicate = true;
+      }
+    }
+    if( !duplicate )
+    {
+      next->write(state);
+    }
+  }
+
+  for( unsigned int i=0; i<runs.size(); i++ )
+  {
+    delete runs[i];
+  }
+  runs.clear();
+}
+
+inline int BFIDA::searchIteration( const SearchState & start, const int & costLimit )
+{
+  StateFile * previous = NULL;
+  StateFile * current = new StateFile();
+  current->write(start.state);
+  std::vector<StateFile*> runs;
+  int solutionCost = -1;
+
+  for( int g=0; solutionCost < 0 && current->size() > 0; g++ )
+  {
+    maxLayerSize = std::max(maxLayerSize, current->size());
+
+    // Expand the layer, writing the children in sorted runs
+    current->rewind();
+    State parentState;
+    while( solutionCost < 0 && current->read(parentState) )
+    {
+      SearchState parent;
+      parent.state = parentState;
+      parent.init();
+      parent.cost = g;
+      const OpList opList = parent.findSuccessorOperators();
+      for( int i=0; i<opList.length; i++ )
+      {
+        SearchState child = parent;
+        child.apply( opList.ops[i] );
+        generationCount++;
+
+        const int f = child.cost + getHeuristic(child);
+        if( f > costLimit )
+        {
+          minOverflow = std::min(minOverflow, f);
+          continue;
+        }
+        if( child == m_goal )
+        {
+          solutionCost = child.cost;
+          break;
+        }
+        buffer.push_back(child.state);
+        if( (int)buffer.size() == BFIDA_RUN_SIZE )
+        {
+          writeRun(runs);
+        }
+      }
+    }
+    if( solutionCost >= 0 )
+    {
+      break;
+    }
+    if( !buffer.empty() )
+    {
+      writeRun(runs);
+    }
+
+    // Remove the duplicates and write the next layer
+    StateFile * next = new StateFile();
+    mergeRuns(runs, current, previous, next);
+    delete previous;
+    previous = current;
+    current = next;
+  }
+
+  for( unsigned int i=0; i<runs.size(); i++ )
+  {
+    delete runs[i];
+  }
+  buffer.clear();
+  runLevels.clear();
+  delete previous;
+  delete current;
+  return solutionCost;
+}
+
+inline int BFIDA::search(const SearchState & start, const SearchState & goal)
+{
+  generationCount = 1;
+  numIterations = 0;
+  maxLayerSize = 0;
+  result.clear();
+  m_goal = goal;
+  if( start == m_goal )
+  {
+    result.solutionLength = 0;
+    return 0;
+  }
+
+  const double startTime = getWallTime();
+  double lastTime = 0.0;
+  long long lastNodeCount = 0;
+  int costLimit = getHeuristic(start);
+  int solutionCost = -1;
+  while( solutionCost < 0 && costLimit < MAX_COST )
+  {
+    numIterations++;
+    minOverflow = MAX_COST;
+    solutionCost = searchIteration(start, costLimit);
+
+    const double time = getWallTime() - startTime;
+    result.addIteration( costLimit, generationCount - lastNodeCount, time - lastTime, -1.0 );
+    lastNodeCount = generationCount;
+    lastTime = time;
+    costLimit = minOverflow;
+  }
+
+  result.nodesGenerated = generationCount;
+  result.time = getWallTime() - startTime;
+  result.solutionLength = solutionCost;
+  return solutionCost;
+}
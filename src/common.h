@@ -57,6 +57,14 @@ const int MAX_COST = 150;
 // This will slightly change the TT and perimeterDb entries because the order of expansion will change slightly.
 #define USE_SKIP_TRANS_OP
 
+// Compute the hashes of all the children when a node is expanded,
+// and prefetch their trans table and PerimeterDb entries before searching the first one.
+//#define USE_PREFETCH
+
+// Search each IDA* iteration with a loop over a preallocated stack of DfsFrames
+// instead of idaRecursive. Same nodes are generated, without the call overhead.
+//#define USE_ITERATIVE_IDA
+
 /////////////////////////////////
 // PERIMETER DB /////////////////
 /////////////////////////////////
@@ -66,6 +74,48 @@ const int MAX_COST = 150;
 #define PERIMETER_DB_SIZE 100 // 1000007
 #define USE_LAZY_PERIMETER
 
+// Fill the PerimeterDb with NUM_THREADS threads.  Each iteration is searched
+// down to PERIMETER_SPLIT_DEPTH by one thread, and the subtrees below are handed out to the threads.
+// Entries are updated under PERIMETER_LOCK_STRIPES spin locks (a power of two).
+// Requires USE_PERIMETER_STATE_PRIORITIZATION and USE_LAZY_PERIMETER, so that the
+// finished PerimeterDb doesn't depend on the order the states are reached in.
+//#define USE_PARALLEL_PERIMETER
+const int PERIMETER_SPLIT_DEPTH = 6;
+const int PERIMETER_LOCK_STRIPES = 4096;
+
+// Fill the PerimeterDb with a breadth-first search (PerimeterBFS) instead of DFS.
+// Each layer is generated once and added with its exact distance.
+// The last three layers are kept in memory.
+//#define USE_BFS_PERIMETER
+
+// Keep colliding perimeter states with open addressing (linear probing with Robin Hood
+// insertion) instead of one state per slot.  A state is never more than PERIMETER_MAX_PROBE
+// slots from its home slot; past that, the state that is furthest from home is dropped.
+// Replaces USE_PERIMETER_STATE_PRIORITIZATION.
+//#define USE_PERIMETER_ROBIN_HOOD
+const int PERIMETER_MAX_PROBE = 32;
+
+// Once the PerimeterDb is built, replace it with a read-only FrozenPerimeterDb:
+// a minimal perfect hash of the states, a 16 bit fingerprint and a 4 bit distance each.
+// Only getHeuristic is answered after that.
+// A state that isn't in the index can match a fingerprint and get another state's distance,
+// which is only a lower bound if every state inside the perimeter was kept.  So this requires
+// the exact builder (USE_BFS_PERIMETER and USE_PERIMETER_ROBIN_HOOD), and the PerimeterDb
+// isn't frozen if any state was dropped.
+//#define USE_FROZEN_PERIMETER
+
+// Save the finished PerimeterDb to PERIMETER_FILE.  On later runs the file is
+// mapped read-only instead of building the PerimeterDb again, as long as its header
+// matches the domain, goal, depth and table layout.  Processes that map the same
+// file share its pages.
+//#define USE_PERIMETER_FILE
+#define PERIMETER_FILE "perimeterDb.bin"
+
+// Perimeter search: stop as soon as a perimeter state is reached within the cost limit,
+// and finish the path with the operators recorded when the PerimeterDb was built.
+// Falls back to searching down to the goal when a collision broke the stored path.
+//#define USE_PERIMETER_SEARCH
+
 /////////////////////////////////
 // TRANSPOSITION TABLES /////////
 /////////////////////////////////
@@ -79,6 +129,21 @@ const int MAX_COST = 150;
 
 #define USE_TRANS_TABLE_HEUR_CACHING
 
+// Keep the heuristic values raised during a search in a HeuristicStore
+// that lives across all the instances, and is saved to HEURISTIC_STORE_FILE
+// at the end of a run and loaded again by the next run.
+// All the instances must have the same goal.
+//#define USE_HEURISTIC_STORE
+const int HEURISTIC_STORE_SIZE = 1000003;
+#define HEURISTIC_STORE_FILE "heuristicStore.bin"
+
+// Cache the heuristic values raised during a search in a HeuristicCache, apart from the trans table.
+// A slot is 4 bytes (a short signature and the value) instead of a whole trans table entry,
+// and the values aren't lost when trans table entries are replaced.
+// HEURISTIC_CACHE_SIZE must be a power of two.
+//#define USE_HEURISTIC_CACHE
+const int HEURISTIC_CACHE_SIZE = 1 << 20;
+
 // Do NOT use 2^x, use a prime number
 //const int TT_SIZE = 40000007;	// large
 //const int TT_SIZE = 5000007;	// medium-large
@@ -87,11 +152,68 @@ const int MAX_COST = 150;
 const int TT_SIZE = 107;		// small
 //const int TT_SIZE = 15;		// small
 
+// Size the trans table and the PerimeterDb from a memory budget at startup,
+// instead of TT_SIZE and PERIMETER_DB_SIZE:  Search [ttMegabytes [perimeterDbMegabytes]]
+// The number of entries is rounded down to a power of two and indexed with a mask,
+// and the tables are backed by transparent huge pages.
+//#define USE_RUNTIME_TABLE_SIZE
+const double DEFAULT_TT_MEGABYTES = 1.0;
+const double DEFAULT_PERIMETER_DB_MEGABYTES = 1.0;
+
+// Start the trans table at TT_RESIZE_INITIAL_MEGABYTES and double it whenever
+// more than TT_RESIZE_LOAD of its entries are used, as long as the old and the new table
+// together fit in the trans table budget.  The entries of the old table are moved
+// TT_RESIZE_STEP at a time on the following probes, so there is no pause to rehash.
+// Requires USE_RUNTIME_TABLE_SIZE.
+//#define USE_TT_RESIZE
+const double TT_RESIZE_INITIAL_MEGABYTES = 0.25;
+const double TT_RESIZE_LOAD = 0.5;
+const int TT_RESIZE_STEP = 4;
+
 // When using a trans table, lazy evaluation can be used 
 // to avoid clearing the table every time.
 // This also allows for less node expansions.
 #define USE_LAZY_TRANS_TABLE
 
+// Stamp every entry with the search it was written on, so that reset()
+// only has to start a new epoch instead of clearing every entry.
+//#define USE_TT_EPOCH
+
+// Store a 32 bit signature of the state instead of the State itself,
+// and the costs in single bytes. An entry is 8 bytes instead of 52 (3x3) or 84 (4x4),
+// so TT_SIZE can be raised by that factor for the same memory.
+// Two states with the same index and signature are taken to be the same.
+//#define USE_COMPACT_TRANS_TABLE
+// Also keep the full State in each entry, to count how often that happens.
+// Requires USE_COMPACT_TRANS_TABLE.
+//#define USE_TT_SIGNATURE_CHECK
+
+// Group the trans table into buckets of TT_BUCKET_WAYS entries, each starting on a cache line.
+// A state may go in any entry of its bucket, so two colliding states can both be kept.
+// TT_SIZE is still the total number of entries.
+//#define USE_TT_BUCKETS
+const int CACHE_LINE_SIZE = 64;
+#ifdef USE_COMPACT_TRANS_TABLE
+const int TT_BUCKET_WAYS = 8;	// a cache line of compact entries
+#else
+const int TT_BUCKET_WAYS = 4;
+#endif
+
+// Which entry of a full bucket is replaced by a new state (pick one)
+// AGE     - the entry reached on the oldest iteration, then the deepest one.  Requires USE_LAZY_TRANS_TABLE.
+// COST    - the deepest entry, since it roots the smallest subtree
+// SUBTREE - the entry with the fewest nodes generated below it on its last expansion
+#define USE_TT_REPLACE_AGE
+//#define USE_TT_REPLACE_COST
+//#define USE_TT_REPLACE_SUBTREE
+
+// Put a small direct-mapped table in front of the trans table, that stays in the cache.
+// New states go into the front table.  The state they displace is moved to the main table,
+// and a state found in the main table is moved back to the front.
+// TT_L1_SIZE must be a power of two; 512 full 3x3 entries fit in a 32KB L1 data cache.
+//#define USE_TT_L1
+const int TT_L1_SIZE = 512;
+
 // The new search technique relies on having a transposition table.
 // We can scan through the transposition table to restart the search iterations
 // instead of starting from the start node each time.
@@ -128,6 +250,135 @@ const int TT_SIZE = 107;		// small
 #define USE_INCREMENTAL_HEURISTIC
 #define USE_BPMX
 
+// Write the heuristic values raised by BPMX back to the caches
+#if (defined USE_TRANS_TABLE && defined USE_TRANS_TABLE_HEUR_CACHING) || defined USE_HEURISTIC_CACHE || defined USE_HEURISTIC_STORE
+  #define USE_HEURISTIC_UPDATES
+#endif
+
+/////////////////////////////////
+// A* ///////////////////////////
+/////////////////////////////////
+
+// Solve the instances with A* instead of IDA*.
+// Every generated state is kept in memory, so there are no re-expansions.
+// Uses the same heuristic and PerimeterDb as IDA*, but no trans table.
+//#define USE_ASTAR
+#ifdef USE_ASTAR
+  #define USE_HASH	// the open and closed lists are keyed on the hash
+#endif
+
+// Solve the instances with breadth-first iterative deepening A* (BFIDA*).
+// Every layer of the breadth-first search is kept in a sorted file on disk,
+// and duplicates are removed by merging the files.
+// Children are sorted in memory in runs of BFIDA_RUN_SIZE states before they are written.
+// At most BFIDA_MERGE_FAN_IN runs are merged at once, so the number of open files stays small.
+// Each file is buffered with BFIDA_FILE_BUFFER bytes.
+//#define USE_BFIDA
+const int BFIDA_RUN_SIZE = 1<<20;
+const int BFIDA_MERGE_FAN_IN = 64;
+const int BFIDA_FILE_BUFFER = 64*1024;
+
+/////////////////////////////////
+// THRESHOLDS ///////////////////
+/////////////////////////////////
+
+// IDA* starts with the heuristic of the start state as cost limit.
+// Each following cost limit is the smallest f-value that went over the previous one.
+// With IDA*_CR, the next cost limit is instead picked from a histogram of those f-values,
+// so that about as many nodes are cut off below it as were generated on the last iteration.
+// This roughly doubles the tree every iteration, but the solution may not be optimal.
+//#define USE_IDA_CR
+
+/////////////////////////////////
+// PARALLEL SEARCH //////////////
+/////////////////////////////////
+
+// Expand each IDA* iteration up to PARALLEL_SPLIT_DEPTH and hand the
+// subtrees below it to a pool of NUM_THREADS worker threads.
+// Each worker has its own SearchState and transposition table.
+//#define USE_PARALLEL_IDA
+const int NUM_THREADS = 4;
+const int PARALLEL_SPLIT_DEPTH = 6;
+
+// Instead of a static split at the root, every worker searches with an explicit stack
+// and idle workers steal the untried siblings (the rest of the OpList)
+// at the shallowest level of a busy worker's stack.
+// This balances the lopsided last iterations much better.
+// Requires USE_PARALLEL_IDA.
+//#define USE_WORK_STEALING
+
+// Solve the instances once for every thread count 1..NUM_THREADS
+// and report the speedup over the single threaded run.
+//#define USE_THREAD_SCALING_BENCHMARK
+
+// Solve NUM_THREADS instances at once, each with its own IDA and trans table.
+// All workers share the same PerimeterDb, which is read-only once built.
+//#define USE_BATCH_SOLVER
+
+// All workers of the parallel search probe and update one transposition table
+// of NUM_THREADS*TT_SIZE entries, without locks.
+// Requires USE_PARALLEL_IDA and USE_TRANS_TABLE.
+//#define USE_SHARED_TRANS_TABLE
+
+// Solve the instances with per-thread trans tables and then with the shared table,
+// and report the hit rate of both.
+// Requires USE_SHARED_TRANS_TABLE.
+//#define USE_TT_SHARING_BENCHMARK
+
+#if defined USE_BATCH_SOLVER && defined USE_PARALLEL_IDA
+#  error USE_BATCH_SOLVER and USE_PARALLEL_IDA can not be combined
+#endif
+#if defined USE_PERIMETER_SEARCH && !defined USE_PERIMETER_DB
+#  error USE_PERIMETER_SEARCH requires USE_PERIMETER_DB
+#endif
+#if defined USE_ASTAR && (defined USE_PARALLEL_IDA || defined USE_BATCH_SOLVER)
+#  error USE_ASTAR can not be combined with USE_PARALLEL_IDA or USE_BATCH_SOLVER
+#endif
+#if defined USE_BFIDA && (defined USE_PARALLEL_IDA || defined USE_BATCH_SOLVER || defined USE_ASTAR)
+#  error USE_BFIDA can not be combined with USE_PARALLEL_IDA, USE_BATCH_SOLVER or USE_ASTAR
+#endif
+#if defined USE_SHARED_TRANS_TABLE && !(defined USE_PARALLEL_IDA && defined USE_TRANS_TABLE)
+#  error USE_SHARED_TRANS_TABLE requires USE_PARALLEL_IDA and USE_TRANS_TABLE
+#endif
+#if defined USE_TT_SIGNATURE_CHECK && !defined USE_COMPACT_TRANS_TABLE
+#  error USE_TT_SIGNATURE_CHECK requires USE_COMPACT_TRANS_TABLE
+#endif
+#if defined USE_TT_BUCKETS && defined USE_TRANS_TABLE_STATE_PRIORITIZATION
+#  error USE_TT_BUCKETS has its own replacement policies, and can not be combined with USE_TRANS_TABLE_STATE_PRIORITIZATION
+#endif
+#if defined USE_TT_BUCKETS && (defined USE_TT_REPLACE_AGE + defined USE_TT_REPLACE_COST + defined USE_TT_REPLACE_SUBTREE != 1)
+#  error USE_TT_BUCKETS requires exactly one of USE_TT_REPLACE_AGE, USE_TT_REPLACE_COST and USE_TT_REPLACE_SUBTREE
+#endif
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_AGE && !defined USE_LAZY_TRANS_TABLE
+#  error USE_TT_REPLACE_AGE requires USE_LAZY_TRANS_TABLE
+#endif
+#if defined USE_PARALLEL_PERIMETER && !(defined USE_PERIMETER_DB && defined USE_PERIMETER_STATE_PRIORITIZATION && defined USE_LAZY_PERIMETER)
+#  error USE_PARALLEL_PERIMETER requires USE_PERIMETER_DB, USE_PERIMETER_STATE_PRIORITIZATION and USE_LAZY_PERIMETER
+#endif
+#if defined USE_PERIMETER_ROBIN_HOOD && (!defined USE_PERIMETER_DB || defined USE_PERIMETER_STATE_PRIORITIZATION || defined USE_PARALLEL_PERIMETER)
+#  error USE_PERIMETER_ROBIN_HOOD requires USE_PERIMETER_DB, and can not be combined with USE_PERIMETER_STATE_PRIORITIZATION or USE_PARALLEL_PERIMETER
+#endif
+#if defined USE_FROZEN_PERIMETER && (!defined USE_BFS_PERIMETER || !defined USE_PERIMETER_ROBIN_HOOD || defined USE_PERIMETER_SEARCH || defined USE_PERIMETER_FILE)
+#  error USE_FROZEN_PERIMETER requires USE_BFS_PERIMETER and USE_PERIMETER_ROBIN_HOOD, and can not be combined with USE_PERIMETER_SEARCH or USE_PERIMETER_FILE
+#endif
+#if defined USE_PERIMETER_FILE && !defined USE_PERIMETER_DB
+#  error USE_PERIMETER_FILE requires USE_PERIMETER_DB
+#endif
+#if defined USE_BFS_PERIMETER && (!defined USE_PERIMETER_DB || defined USE_PARALLEL_PERIMETER || defined USE_PERIMETER_SCAN_EXPANSION)
+#  error USE_BFS_PERIMETER requires USE_PERIMETER_DB, and can not be combined with USE_PARALLEL_PERIMETER or USE_PERIMETER_SCAN_EXPANSION
+#endif
+#if defined USE_TT_RESIZE && !defined USE_RUNTIME_TABLE_SIZE
+#  error USE_TT_RESIZE requires USE_RUNTIME_TABLE_SIZE
+#endif
+#if defined USE_TT_RESIZE && (defined USE_TT_BUCKETS || defined USE_COMPACT_TRANS_TABLE)
+#  error USE_TT_RESIZE rehashes the states of the entries, and can not be combined with USE_TT_BUCKETS or USE_COMPACT_TRANS_TABLE
+#endif
+#if defined USE_HEURISTIC_STORE && !(defined USE_TRANS_TABLE || defined USE_PERIMETER_DB)
+#  error USE_HEURISTIC_STORE requires USE_HASH (USE_TRANS_TABLE or USE_PERIMETER_DB)
+#endif
+#if defined USE_HEURISTIC_STORE && (defined USE_PARALLEL_IDA || defined USE_BATCH_SOLVER || defined USE_ASTAR || defined USE_BFIDA)
+#  error USE_HEURISTIC_STORE is only used by IDA, and can not be combined with USE_PARALLEL_IDA, USE_BATCH_SOLVER, USE_ASTAR or USE_BFIDA
+#endif
 
 #endif
 
@@ -22,5 +22,21 @@
 #		error no domain specified
 #endif
 
+// A wide (64 bit) hash of the whole state, computed from scratch.
+// Hash::value is only 32 bits and is used for the table index,
+// so this is used to verify table entries that don't store the full State.
+inline unsigned long long getSignature(const State & state)
+{
+  // FNV-1a
+  const unsigned char * bytes = (const unsigned char *)&state;
+  unsigned long long signature = 14695981039346656037ULL;
+  for( unsigned int i=0; i<sizeof(State); i++ )
+  {
+    signature ^= bytes[i];
+    signature *= 1099511628211ULL;
+  }
+  return signature;
+}
+
 
 #endif
@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_FROZEN_PERIMETER
+
+#ifndef FROZEN_PERIMETER_H
+#define FROZEN_PERIMETER_H
+
+#include "common.h"
+#include <vector>
+
+typedef unsigned short fingerprint_t;
+
+// A read-only copy of a finished PerimeterDb that only answers getHeuristic.
+// States are found with a minimal perfect hash of their 64 bit signature
+// (BBHash: levels of bit arrays, FROZEN_GAMMA bits per remaining state each, ranked),
+// so nothing but a fingerprint and a 4 bit distance is stored per state.
+//
+// Distances above base = maxDistance-15 are exact.  Those at or below it are stored as 0,
+// which is still a lower bound.
+// A state that isn't in the index can match a fingerprint (1 in 65536), and then gets
+// the distance of another state.  That is still a lower bound as long as the
+// PerimeterDb held every state within the perimeter, since the other states are further away.
+class FrozenPerimeterDb
+{
+private:
+  std::vector<unsigned long long> bits;		// the levels, one after the other
+  std::vector<unsigned int> blockRank;		// set bits before each block of FROZEN_RANK_BLOCK words
+  std::vector<unsigned long long> levelOffset;	// first bit of each level
+  std::vector<unsigned long long> levelSize;	// bits in each level
+  std::vector<fingerprint_t> fingerprints;
+  std::vector<unsigned char> distances;		// two per byte
+  int base;
+  long long numEntries;
+  long long numDropped;		// states that were still colliding after FROZEN_MAX_LEVELS levels
+
+public:
+  // distances[i] belongs to the state with signatures[i]
+  FrozenPerimeterDb( const std::vector<unsigned long long> & signatures, const std::vector<int> & distances );
+
+  // Returns the distance to the goal, or 0 if the state isn't in the index
+  int getHeuristic( const unsigned long long & signature ) const;
+  long long size() const { return numEntries; }
+  long long getNumDropped() const { return numDropped; }
+  size_t bytes() const;
+  void printInfo(LogLevel level) const;
+
+private:
+  static unsigned long long levelHash( const unsigned long long & signature, const int & level );
+  static fingerprint_t fingerprint( const unsigned long long & signature ) { return (fingerprint_t)(signature >> 48); }
+  bool testBit( const unsigned long long & pos ) const { return (bits[pos>>6] >> (pos&63)) & 1; }
+  unsigned long long rank( const unsigned long long & pos ) const;
+  // returns the index of the state, or -1 if it has none
+  long long findIndex( const unsigned long long & signature ) const;
+};
+
+#include "frozenPerimeter.hpp"
+
+#endif	// FROZEN_PERIMETER_H
+#endif	// USE_FROZEN_PERIMETER
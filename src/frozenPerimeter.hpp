@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#include <algorithm>
+
+const int FROZEN_GAMMA = 2;
+const int FROZEN_MAX_LEVELS = 32;
+const int FROZEN_RANK_BLOCK = 8;	// words
+
+inline FrozenPerimeterDb::FrozenPerimeterDb( const std::vector<unsigned long long> & signatures, const std::vector<int> & _distances )
+: base(0), numEntries(0), numDropped(0)
+{
+  int maxDistance = 0;
+  for( unsigned int i=0; i<_distances.size(); i++ )
+  {
+    maxDistance = std::max(maxDistance, _distances[i]);
+  }
+  base = std::max(0, maxDistance-15);
+
+  // Build the levels.  A state whose position no other state shares keeps it,
+  // the rest move on to the next level.
+  std::vector<unsigned long long> keys(signatures);
+  std::vector<unsigned long long> collisions;
+  std::vector<unsigned long long> remaining;
+  for( int level=0; level<FROZEN_MAX_LEVELS && !keys.empty(); level++ )
+  {
+    const unsigned long long size = ( (keys.size()*FROZEN_GAMMA + 63)/64 )*64;
+    const unsigned long long offset = (unsigned long long)bits.size()*64;
+    levelOffset.push_back(offset);
+    levelSize.push_back(size);
+    bits.resize( bits.size() + size/64, 0 );
+    collisions.assign( size/64, 0 );
+
+    for( unsigned int i=0; i<keys.size(); i++ )
+    {
+      const unsigned long long h = levelHash(keys[i], level) % size;
+      unsigned long long & word = bits[(offset+h)>>6];
+      const unsigned long long mask = 1ULL << (h&63);
+      if( word & mask )
+      {
+        collisions[h>>6] |= mask;
+      }
+      word |= mask;
+    }
+    remaining.clear();
+    for( unsigned int i=0; i<keys.size(); i++ )
+    {
+      const unsigned long long h = levelHash(keys[i], level) % size;
+      if( collisions[h>>6] & (1ULL << (h&63)) )
+      {
+        remaining.push_back(keys[i]);
+      }
+    }
+    for( unsigned long long w=0; w<size/64; w++ )
+    {
+      bits[offset/64 + w] &= ~collisions[w];
+    }
+    keys.swap(remaining);
+  }
+  numDropped = keys.size();
+
+  // Rank
+  blockRank.resize( bits.size()/FROZEN_RANK_BLOCK + 1 );
+  unsigned int count = 0;
+  for( unsigned int w=0; w<bits.size(); w++ )
+  {
+    if( w % FROZEN_RANK_BLOCK == 0 )
+    {
+      blockRank[w/FROZEN_RANK_BLOCK] = count;
+    }
+    count += __builtin_popcountll(bits[w]);
+  }
+  numEntries = count;
+
+  // Values
+  fingerprints.assign( numEntries, 0 );
+  distances.assign( (numEntries+1)/2, 0 );
+  for( unsigned int i=0; i<signatures.size(); i++ )
+  {
+    const long long index = findIndex(signatures[i]);
+    if( index < 0 )
+    {
+      continue;
+    }
+    const int nibble = _distances[i] <= base ? 0 : _distances[i] - base;
+    fingerprints[index] = fingerprint(signatures[i]);
+    distances[index/2] |= nibble << ((index&1)*4);
+  }
+}
+
+// splitmix64 of the signature, with a different seed for each level
+inline unsigned long long FrozenPerimeterDb::levelHash( const unsigned long long & signature, const int & level )
+{
+  unsigned long long z = signature + (level+1)*0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+inline unsigned long long FrozenPerimeterDb::rank( const unsigned long long & pos ) const
+{
+  const unsigned long long word = pos >> 6;
+  unsigned long long count = blockRank[word/FROZEN_RANK_BLOCK];
+  for( unsigned long long w=word - word%FROZEN_RANK_BLOCK; w<word; w++ )
+  {
+    count += __builtin_popcountll(bits[w]);
+  }
+  return count + __builtin_popcountll( bits[word] & ((1ULL << (pos&63)) - 1) );
+}
+
+inline long long FrozenPerimeterDb::findIndex( const unsigned long long & signature ) const
+{
+  for( unsigned int level=0; level<levelOffset.size(); level++ )
+  {
+    const unsigned long long pos = levelOffset[level] + levelHash(signature, level) % levelSize[level];
+    if( testBit(pos) )
+    {
+      return rank(pos);
+    }
+  }
+  return -1;
+}
+
+inline int FrozenPerimeterDb::getHeuristic( const unsigned long long & signature ) const
+{
+  const long long index = findIndex(signature);
+  if( index < 0 || fingerprints[index] != fingerprint(signature) )
+  {
+    return 0;
+  }
+  const int nibble = (distances[index/2] >> ((index&1)*4)) & 0xF;
+  return nibble == 0 ? 0 : base + nibble;
+}
+
+inline size_t FrozenPerimeterDb::bytes() const
+{
+  return bits.size()*sizeof(unsigned long long)
+    + blockRank.size()*sizeof(unsigned int)
+    + fingerprints.size()*sizeof(fingerprint_t)
+    + distances.size();
+}
+
+inline void FrozenPerimeterDb::printInfo(LogLevel level) const
+{
+  _LOG(level,"FrozenPerimeterDb: entries=%12lli, bytes=%lu bitsPerEntry=%f levels=%u base=%i dropped=%lli \n",
+    numEntries, (unsigned long)bytes(), numEntries ? 8.0*bytes()/numEntries : 0.0,
+    (unsigned int)levelOffset.size(), base, numDropped);
+}
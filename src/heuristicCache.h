@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_HEURISTIC_CACHE
+
+#ifndef HEURISTIC_CACHE_H
+#define HEURISTIC_CACHE_H
+
+#include "common.h"
+#include "domain.h"
+
+// Probe counters for a heuristic cache, since the last reset
+struct HeuristicCacheStats
+{
+  long long     probes;
+  long long     hits;
+  long long     raises;		// hits that raised the heuristic of the node (counted by the caller)
+  long long     writes;
+
+  HeuristicCacheStats() { reset(); }
+  void reset() { probes = 0; hits = 0; raises = 0; writes = 0; }
+  double hitRate() const { return probes ? (double)hits/(double)probes : 0.0; }
+};
+
+// A lossy cache of heuristic values, apart from the trans table.
+// Each slot is 4 bytes: the high 24 bits of the state's 64 bit signature, and the value in one byte.
+// The slot is picked by the low bits of the signature, so a state is
+// only confused with another one if 44 bits of their signatures match.
+// A new value always takes over the slot.
+// The values are lower bounds on the distance to the goal, so the cache must be cleared when the goal changes.
+class HeuristicCache
+{
+private:
+  unsigned int * slots;		// HEURISTIC_CACHE_SIZE of them, 0 if empty
+
+public:
+  HeuristicCacheStats stats;
+
+public:
+  HeuristicCache() { slots = new unsigned int[HEURISTIC_CACHE_SIZE]; clear(); }
+  ~HeuristicCache() { delete[] slots; }
+
+  void clear();
+
+  // Returns the cached value, or 0 if the state isn't in the cache
+  int getHeuristic( const unsigned long long & signature );
+  // Caches the value if it is larger than the cached one, or if the slot holds another state
+  void update( const unsigned long long & signature, const int & value );
+
+  // Stats
+  void printInfo(LogLevel level) const;
+
+private:
+  static unsigned int index( const unsigned long long & signature );
+  static unsigned int tag( const unsigned long long & signature );
+
+  // Not copyable
+  HeuristicCache(const HeuristicCache &);
+  HeuristicCache & operator=(const HeuristicCache &);
+};
+
+#include "heuristicCache.hpp"
+
+#endif	// HEURISTIC_CACHE_H
+#endif	// USE_HEURISTIC_CACHE
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+inline unsigned int HeuristicCache::index( const unsigned long long & signature )
+{
+  return (unsigned int)signature & (HEURISTIC_CACHE_SIZE - 1);
+}
+
+// The tag is shifted up, leaving the low byte for the value
+inline unsigned int HeuristicCache::tag( const unsigned long long & signature )
+{
+  return (unsigned int)(signature >> 32) & 0xFFFFFF00;
+}
+
+inline void HeuristicCache::clear()
+{
+  for( int i=0; i<HEURISTIC_CACHE_SIZE; i++ )
+  {
+    slots[i] = 0;
+  }
+}
+
+inline int HeuristicCache::getHeuristic( const unsigned long long & signature )
+{
+  stats.probes++;
+  const unsigned int slot = slots[index(signature)];
+  if( slot != 0 && (slot & 0xFFFFFF00) == tag(signature) )
+  {
+    stats.hits++;
+    return slot & 0xFF;
+  }
+  return 0;
+}
+
+inline void HeuristicCache::update( const unsigned long long & signature, const int & value )
+{
+  if( value <= 0 )
+  {	// Not worth a slot
+    return;
+  }
+  unsigned int & slot = slots[index(signature)];
+  const unsigned int newSlot = tag(signature) | (unsigned int)std::min(value, 255);
+  if( (slot & 0xFFFFFF00) == tag(signature) && newSlot <= slot )
+  {	// Already cached with a value at least as large
+    return;
+  }
+  slot = newSlot;
+  stats.writes++;
+}
+
+inline void HeuristicCache::printInfo(LogLevel level) const
+{
+  long long fill = 0;
+  for( int i=0; i<HEURISTIC_CACHE_SIZE; i++ )
+  {
+    if( slots[i] != 0 )
+    {
+      fill++;
+    }
+  }
+  _LOG(level,"HeuristicCache: size=%i, entries=%12lli, fill=%f hitRate=%f raises=%lli writes=%lli \n",
+    HEURISTIC_CACHE_SIZE, fill, (double)fill/HEURISTIC_CACHE_SIZE, stats.hitRate(), stats.raises, stats.writes);
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_HEURISTIC_STORE
+
+#ifndef HEURISTIC_STORE_H
+#define HEURISTIC_STORE_H
+
+#include "common.h"
+#include "domain.h"
+
+class HeuristicStoreEntry
+{
+public:
+  State         state;
+  int           value;		// lower bound on the cost to the goal, 0 if the entry is empty
+
+public:
+  HeuristicStoreEntry() : state(), value(0) {}
+};
+
+// Heuristic values that were raised during a search (through BPMX),
+// kept from one instance to the next.
+// The values are lower bounds on the distance to the goal, so they are only valid
+// for the goal they were learnt with.  All the instances of a run share the goal.
+// Only one search may use the store at a time.
+class HeuristicStore
+{
+private:
+  HeuristicStoreEntry * store;
+  long long numImproved;	// calls to update that raised a value
+
+public:
+  HeuristicStore() : numImproved(0) { store = new HeuristicStoreEntry[HEURISTIC_STORE_SIZE]; }
+  ~HeuristicStore() { delete[] store; }
+
+  // Returns the stored lower bound of the state, or 0 if it is not in the store
+  int getHeuristic( const State & state, const Hash & hash ) const;
+  // Stores the value if it is larger than the one already there.
+  // A state with a larger value takes over the entry of another state.
+  void update( const State & state, const Hash & hash, const int & value );
+
+  // returns false if the file couldn't be written or read.
+  // A file written for a different domain, puzzle size, goal or table size is not loaded.
+  bool save( const char * filename, const State & goal ) const;
+  bool load( const char * filename, const State & goal );
+
+  // Stats
+  void printInfo(LogLevel level) const;
+
+private:
+  unsigned int calculateIndex( const Hash & hash ) const;
+  long long numEntries() const;
+
+  // Not copyable
+  HeuristicStore(const HeuristicStore &);
+  HeuristicStore & operator=(const HeuristicStore &);
+};
+
+#include "heuristicStore.hpp"
+
+#endif	// HEURISTIC_STORE_H
+#endif	// USE_HEURISTIC_STORE
@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Written at the start of a saved store.
+// The values are only lower bounds for the goal and moves they were learnt with,
+// so a store is only loaded by a build with the same domain, size and goal.
+struct HeuristicStoreHeader
+{
+  char          magic[8];
+  unsigned int  domain;
+  unsigned int  dimensions[2];	// width and height, or the number of pancakes
+  unsigned int  goalHash;		// Hash of the goal. Changes with the hash seed.
+  unsigned int  size;
+  unsigned int  entrySize;
+  State         goal;
+};
+
+const char HEURISTIC_STORE_MAGIC[8] = "HSTORE2";
+
+// The header this build writes, and expects to read
+inline void makeHeuristicStoreHeader( HeuristicStoreHeader & header, const State & goal )
+{
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HEURISTIC_STORE_MAGIC, sizeof(header.magic));
+  header.domain = DOMAIN;
+#if DOMAIN == 1
+  header.dimensions[0] = WIDTH;
+  header.dimensions[1] = HEIGHT;
+#else
+  header.dimensions[0] = NUM_PANCAKES;
+  header.dimensions[1] = 1;
+#endif
+  Hash hash;
+  hash.calculateHash(goal);
+  header.goalHash = hash.value;
+  header.size = HEURISTIC_STORE_SIZE;
+  header.entrySize = sizeof(HeuristicStoreEntry);
+  header.goal = goal;
+}
+
+inline unsigned int HeuristicStore::calculateIndex( const Hash & hash ) const
+{
+  return hash.value%HEURISTIC_STORE_SIZE;
+}
+
+inline int HeuristicStore::getHeuristic( const State & state, const Hash & hash ) const
+{
+  const HeuristicStoreEntry & entry = store[calculateIndex(hash)];
+  if( entry.value != 0 && entry.state == state )
+  {
+    return entry.value;
+  }
+  return 0;
+}
+
+inline void HeuristicStore::update( const State & state, const Hash & hash, const int & value )
+{
+  HeuristicStoreEntry & entry = store[calculateIndex(hash)];
+  if( value > entry.value )
+  {
+    entry.state = state;
+    entry.value = value;
+    numImproved++;
+  }
+}
+
+inline bool HeuristicStore::save( const char * filename, const State & goal ) const
+{
+  // Write a temporary file and move it over the old one,
+  // so a crash while saving doesn't leave a truncated store behind.
+  std::string tempName = std::string(filename) + ".XXXXXX";
+  const int fd = mkstemp(&tempName[0]);
+  if( fd < 0 )
+  {
+    return false;
+  }
+  fchmod(fd, 0644);
+  FILE * file = fdopen(fd, "wb");
+  if( !file )
+  {
+    close(fd);
+    unlink(tempName.c_str());
+    return false;
+  }
+  HeuristicStoreHeader header;
+  makeHeuristicStoreHeader(header, goal);
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+    && fwrite(store, sizeof(HeuristicStoreEntry), HEURISTIC_STORE_SIZE, file) == (size_t)HEURISTIC_STORE_SIZE
+    && fflush(file) == 0
+    && fsync(fd) == 0;
+  ok = (fclose(file) == 0) && ok;
+  ok = ok && rename(tempName.c_str(), filename) == 0;
+  if( !ok )
+  {
+    unlink(tempName.c_str());
+  }
+  return ok;
+}
+
+inline bool HeuristicStore::load( const char * filename, const State & goal )
+{
+  FILE * file = fopen(filename, "rb");
+  if( !file )
+  {
+    return false;
+  }
+  HeuristicStoreHeader expected;
+  makeHeuristicStoreHeader(expected, goal);
+  HeuristicStoreHeader header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1;
+  if( ok && memcmp(&header, &expected, sizeof(header)) != 0 )
+  {
+    LOG_ERROR("%s doesn't match this build, starting with an empty HeuristicStore\n", filename);
+    ok = false;
+  }
+  ok = ok && fread(store, sizeof(HeuristicStoreEntry), HEURISTIC_STORE_SIZE, file) == (size_t)HEURISTIC_STORE_SIZE;
+  fclose(file);
+  if( !ok )
+  {	// Don't keep half a store
+    HeuristicStoreEntry entry;
+    for( int i=0; i<HEURISTIC_STORE_SIZE; i++ )
+    {
+      store[i] = entry;
+    }
+  }
+  return ok;
+}
+
+inline long long HeuristicStore::numEntries() const
+{
+  long long fill = 0;
+  for( int i=0; i<HEURISTIC_STORE_SIZE; i++ )
+  {
+    if( store[i].value != 0 )
+    {
+      fill++;
+    }
+  }
+  return fill;
+}
+
+inline void HeuristicStore::printInfo(LogLevel level) const
+{
+  const long long entries = numEntries();
+  _LOG(level,"HeuristicStore: size=%i, entries=%12lli, fill=%f improved=%lli \n",
+    HEURISTIC_STORE_SIZE, entries, (double)entries/HEURISTIC_STORE_SIZE, numImproved);
+}
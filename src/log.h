@@ -18,6 +18,7 @@
 
 #include <time.h>
 #include <stdio.h>
+#include <sys/time.h>
 
 /////////////////////////////////
 // MACROS ///////////////////////
@@ -44,6 +45,15 @@ void printTime(LogLevel level)
   _LOG(level,"%s",ctime(&t));
 }
 
+// Wall clock time in seconds.
+// clock() measures the cpu time of all threads, so use this for parallel runs.
+double getWallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec/1000000.0;
+}
+
 
 #endif
 
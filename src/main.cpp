@@ -17,17 +17,37 @@
 #include "domain.h"
 #include "search.h"
 #include "perimeterDB.h"
+#include "perimeterBFS.h"
+#include "parallelSearch.h"
+#include "batchSolver.h"
+#include "astar.h"
+#include "bfida.h"
 #include <vector>
 #include <fstream>
 
 // Declarations
 void initializeStartStates(std::vector<SearchState> & states);
+#ifdef USE_THREAD_SCALING_BENCHMARK
+#ifdef USE_PERIMETER_DB
+void benchmarkThreadScaling(const PerimeterDb & perimeterDb, const std::vector<SearchState> & states, const SearchState & goal, const int numSearches);
+#else
+void benchmarkThreadScaling(const std::vector<SearchState> & states, const SearchState & goal, const int numSearches);
+#endif
+#endif
+#ifdef USE_TT_SHARING_BENCHMARK
+#ifdef USE_PERIMETER_DB
+void benchmarkTransTableSharing(const PerimeterDb & perimeterDb, const std::vector<SearchState> & states, const SearchState & goal, const int numSearches);
+#else
+void benchmarkTransTableSharing(const std::vector<SearchState> & states, const SearchState & goal, const int numSearches);
+#endif
+#endif
 
 // Main
 int main( int argc, const char* argv[]  )
 {
   double avgLength = 0.0;
   double avgNodesGen = 0.0;
+  double avgIterations = 0.0;
   int numSearches = 100;
 
   SearchState goal;
@@ -35,24 +55,136 @@ int main( int argc, const char* argv[]  )
   initializeStartStates(startingStates);
   LOG_ERROR("LogLevel =%i\n", g_logLevel);
 
+#ifdef USE_RUNTIME_TABLE_SIZE
+  // Search [ttMegabytes [perimeterDbMegabytes]]
+  if( argc > 1 )
+  {
+    g_transTableBytes = (size_t)(atof(argv[1])*1024*1024);
+  }
+  if( argc > 2 )
+  {
+    g_perimeterDbBytes = (size_t)(atof(argv[2])*1024*1024);
+  }
+  LOG_ERROR("TransTableBytes =%lu PerimeterDbBytes =%lu\n", (unsigned long)g_transTableBytes, (unsigned long)g_perimeterDbBytes);
+#endif
+
   // Preprocess the state space
 #ifdef USE_PERIMETER_DB
   LOG_ERROR("PerimeterDepth =%i\n", PERIMETER_DEPTH);
+#ifdef USE_PERIMETER_FILE
+  PerimeterDb perimeterDb(PERIMETER_FILE, goal.state, PERIMETER_DEPTH);
+  if( perimeterDb.isMapped() )
+  {
+    LOG_ERROR("Mapped %s\n", PERIMETER_FILE);
+  }
+  else
+#else
   PerimeterDb perimeterDb;
-  DFS dfs(perimeterDb);
-  dfs.search(goal, PERIMETER_DEPTH);
+#endif
+  {
+#ifdef USE_BFS_PERIMETER
+    PerimeterBFS bfs(perimeterDb);
+    bfs.search(goal, PERIMETER_DEPTH);
+    LOG_ERROR("PerimeterBFS: states=%lli generated=%lli\n", bfs.getNumStates(), bfs.getNodesGenerated());
+    perimeterDb.printCoverage(ERROR, bfs.getNumStates());
+#else
+    DFS dfs(perimeterDb);
+    dfs.search(goal, PERIMETER_DEPTH);
+#endif
+#ifdef USE_PERIMETER_FILE
+    if( !perimeterDb.save(PERIMETER_FILE, goal.state, PERIMETER_DEPTH) )
+    {
+      LOG_ERROR("Could not write %s\n", PERIMETER_FILE);
+    }
+#endif
+  }
   perimeterDb.printInfo(ERROR);
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  perimeterDb.printProbeHistogram(ERROR);
+#endif
+#ifdef USE_FROZEN_PERIMETER
+  if( perimeterDb.freeze() )
+  {
+    perimeterDb.printInfo(ERROR);
+  }
+#endif
   LOG("\n");
 #endif
 
-  // Search algorithm
+#ifdef USE_THREAD_SCALING_BENCHMARK
+#ifdef USE_PERIMETER_DB
+  benchmarkThreadScaling(perimeterDb, startingStates, goal, numSearches);
+#else
+  benchmarkThreadScaling(startingStates, goal, numSearches);
+#endif
+  return 0;
+#endif
+
+#ifdef USE_TT_SHARING_BENCHMARK
+#ifdef USE_PERIMETER_DB
+  benchmarkTransTableSharing(perimeterDb, startingStates, goal, numSearches);
+#else
+  benchmarkTransTableSharing(startingStates, goal, numSearches);
+#endif
+  return 0;
+#endif
+
+#ifdef USE_BATCH_SOLVER
+  // The perimeter db is frozen from here on. All workers share it.
 #ifdef USE_PERIMETER_DB
+  BatchSolver batchSolver(perimeterDb);
+#else
+  BatchSolver batchSolver;
+#endif
+  LOG_ERROR("BatchSolver threads=%i\n", batchSolver.getNumThreads());
+  const std::vector<SearchState> batch(startingStates.begin(), startingStates.begin()+numSearches);
+  std::vector<SearchResult> results;
+
+  // The results are printed in input order once the batch is done
+  const double startTime = getWallTime();
+  batchSolver.solve(batch, goal, results);
+  const double totalTime = getWallTime() - startTime;
+
+  for( int i=0; i<numSearches; i++)
+  {
+    results[i].print(NORMAL);
+    LOG_WARN("SolutionNumber %i Solution length %i Nodes Generated %lli Iterations %i time %f\n",
+      i, results[i].solutionLength, results[i].nodesGenerated, results[i].getIterations(), results[i].time);
+    avgLength += results[i].solutionLength;
+    avgNodesGen += results[i].nodesGenerated;
+    avgIterations += results[i].getIterations();
+  }
+#else
+  // Search algorithm
+#if defined USE_PARALLEL_IDA && defined USE_PERIMETER_DB
+  ParallelIDA idaSearch(perimeterDb);
+#elif defined USE_PARALLEL_IDA
+  ParallelIDA idaSearch;
+#elif defined USE_ASTAR && defined USE_PERIMETER_DB
+  AStar idaSearch(perimeterDb);
+#elif defined USE_ASTAR
+  AStar idaSearch;
+#elif defined USE_BFIDA && defined USE_PERIMETER_DB
+  BFIDA idaSearch(perimeterDb);
+#elif defined USE_BFIDA
+  BFIDA idaSearch;
+#elif defined USE_PERIMETER_DB
   IDA idaSearch(perimeterDb);
 #else
   IDA idaSearch;
 #endif
+#ifdef USE_HEURISTIC_STORE
+  HeuristicStore heuristicStore;
+  if( heuristicStore.load(HEURISTIC_STORE_FILE, goal.state) )
+  {
+    LOG_ERROR("Loaded %s\n", HEURISTIC_STORE_FILE);
+  }
+  heuristicStore.printInfo(ERROR);
+  idaSearch.setHeuristicStore(&heuristicStore);
+#endif
 
 	// Search
+  const double startTime = getWallTime();
   for( int i=0; i<numSearches; i++)
   {
     SearchState & state = startingStates[i];	// copy
@@ -64,27 +196,139 @@ int main( int argc, const char* argv[]  )
     LOG("\n");
 
     printTime(WARN);
-    int solutionLength = idaSearch.search(state, goal);
-    long long nodesGenerated = idaSearch.getNodesGenerated();
-    LOG_WARN("SolutionNumber %i Solution length %i Nodes Generated %lli\n", i, solutionLength, nodesGenerated);
+    idaSearch.search(state, goal);
+    const SearchResult & result = idaSearch.getResult();
+    result.print(NORMAL);
+#ifdef USE_PARALLEL_IDA
+    idaSearch.printThreadInfo(NORMAL);
+#endif
+#ifdef USE_ASTAR
+    LOG("expCnt=%13lld nodes=%lli\n", idaSearch.getNodesExpanded(), idaSearch.getNodesStored());
+#endif
+#ifdef USE_BFIDA
+    LOG("maxLayer=%lli\n", idaSearch.getMaxLayerSize());
+#endif
+    const int solutionLength = result.solutionLength;
+    const long long nodesGenerated = result.nodesGenerated;
+    const int iterations = result.getIterations();
+    LOG_WARN("SolutionNumber %i Solution length %i Nodes Generated %lli Iterations %i\n", i, solutionLength, nodesGenerated, iterations);
 
     avgLength += solutionLength;
     avgNodesGen += nodesGenerated;
+    avgIterations += iterations;
 
+#ifndef USE_PARALLEL_IDA
 #ifdef USE_PERIMETER_DB
     idaSearch.perimeterDb.printInfo(ERROR);
 #endif
-#ifdef USE_TRANS_TABLE
+#if defined USE_TRANS_TABLE && !defined USE_ASTAR && !defined USE_BFIDA
     idaSearch.transTable.printInfo(ERROR);
+#endif
+#if defined USE_HEURISTIC_CACHE && !defined USE_ASTAR && !defined USE_BFIDA
+    idaSearch.heuristicCache.printInfo(ERROR);
+#endif
 #endif
   }
+  const double totalTime = getWallTime() - startTime;
+#ifdef USE_HEURISTIC_STORE
+  heuristicStore.printInfo(ERROR);
+  if( !heuristicStore.save(HEURISTIC_STORE_FILE, goal.state) )
+  {
+    LOG_ERROR("Could not write %s\n", HEURISTIC_STORE_FILE);
+  }
+#endif
+#endif
 
   LOG_ERROR("\n");
-  LOG_ERROR(" avgSolLength %f avgNodesGenerated %f numSearches %i \n", avgLength/numSearches, avgNodesGen/numSearches, numSearches);
+  LOG_ERROR(" avgSolLength %f avgNodesGenerated %f avgIterations %f numSearches %i instPerSec %f \n",
+    avgLength/numSearches, avgNodesGen/numSearches, avgIterations/numSearches, numSearches, numSearches/totalTime);
 
 	return 0;
 }
 
+#ifdef USE_THREAD_SCALING_BENCHMARK
+// Solve all the instances once for each number of threads
+// and report the speedup relative to a single thread.
+#ifdef USE_PERIMETER_DB
+void benchmarkThreadScaling(const PerimeterDb & perimeterDb, const std::vector<SearchState> & states, const SearchState & goal, const int numSearches)
+#else
+void benchmarkThreadScaling(const std::vector<SearchState> & states, const SearchState & goal, const int numSearches)
+#endif
+{
+  // The per-iteration output of the searches is not interesting here
+  const LogLevel logLevel = g_logLevel;
+  g_logLevel = ERROR;
+
+  double singleThreadTime = 0.0;
+  for( int numThreads=1; numThreads<=NUM_THREADS; numThreads++ )
+  {
+#ifdef USE_PERIMETER_DB
+    ParallelIDA idaSearch(perimeterDb, numThreads);
+#else
+    ParallelIDA idaSearch(numThreads);
+#endif
+    long long nodesGenerated = 0;
+    const double startTime = getWallTime();
+    for( int i=0; i<numSearches; i++ )
+    {
+      idaSearch.search(states[i], goal);
+      nodesGenerated += idaSearch.getNodesGenerated();
+    }
+    const double time = getWallTime() - startTime;
+    if( numThreads == 1 )
+    {
+      singleThreadTime = time;
+    }
+    LOG_ERROR("threads=%2i time=%8.2fsec genCnt=%13lld nps=%11.f speedup=%5.2f\n",
+      numThreads, time, nodesGenerated, nodesGenerated/time, singleThreadTime/time );
+  }
+
+  g_logLevel = logLevel;
+}
+#endif
+
+#ifdef USE_TT_SHARING_BENCHMARK
+// Solve all the instances with a trans table per thread,
+// and then with one shared table of the same total number of entries.
+#ifdef USE_PERIMETER_DB
+void benchmarkTransTableSharing(const PerimeterDb & perimeterDb, const std::vector<SearchState> & states, const SearchState & goal, const int numSearches)
+#else
+void benchmarkTransTableSharing(const std::vector<SearchState> & states, const SearchState & goal, const int numSearches)
+#endif
+{
+  const LogLevel logLevel = g_logLevel;
+  g_logLevel = ERROR;
+
+#ifdef USE_PERIMETER_DB
+  ParallelIDA idaSearch(perimeterDb);
+#else
+  ParallelIDA idaSearch;
+#endif
+  for( int shared=0; shared<=1; shared++ )
+  {
+    idaSearch.setSharedTransTable(shared);
+    long long nodesGenerated = 0;
+    long long probes = 0;
+    long long hits = 0;
+    const double startTime = getWallTime();
+    for( int i=0; i<numSearches; i++ )
+    {
+      idaSearch.search(states[i], goal);
+      nodesGenerated += idaSearch.getNodesGenerated();
+      const TransTableStats stats = idaSearch.getTransTableStats();
+      probes += stats.probes;
+      hits += stats.hits;
+    }
+    const double time = getWallTime() - startTime;
+    LOG_ERROR("%s threads=%2i time=%8.2fsec genCnt=%13lld nps=%11.f ttProbes=%13lld ttHits=%13lld hitRate=%.4f\n",
+      shared ? "shared    " : "perThread ", idaSearch.getNumThreads(), time, nodesGenerated, nodesGenerated/time,
+      probes, hits, probes ? (double)hits/probes : 0.0 );
+  }
+
+  g_logLevel = logLevel;
+}
+#endif
+
  void initializeStartStates(std::vector<SearchState> & states)
 {
 #ifdef INPUT_FILE
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_PARALLEL_IDA
+
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include "common.h"
+#include "domain.h"
+#include "searchState.h"
+#include "search.h"
+#include <pthread.h>
+#include <vector>
+
+// A node at the split depth, the heuristic of its parent (for BPMX),
+// and the operators from the start to the node.
+struct FrontierNode
+{
+  SearchState   state;
+  int           prevHeuristic;
+  std::vector<Operator> path;
+};
+
+// Parallel IDA* by splitting the tree at the root.
+// Every iteration is expanded up to PARALLEL_SPLIT_DEPTH by the calling thread.
+// The subtrees below the split depth are then handed out
+// one at a time to a pool of worker threads.
+// Each worker is a complete IDA object, so it has its own SearchState,
+// transposition table and generationCount.
+//
+// With USE_WORK_STEALING the iteration starts with the start state as the only work item.
+// Workers search with an explicit stack, and an idle worker asks a busy one for work.
+// The busy worker then gives away the untried children at the shallowest level
+// of its stack (stack splitting), which an idle worker picks up as new work items.
+//
+// A worker only finds the path from its work item to the goal, in IDA::path.
+// The path to the work item is kept with the item, and added to IDA::path
+// by the worker that finds the goal.
+class ParallelIDA
+{
+public:
+  long long generationCount;	// nodes generated above the split depth
+  SearchState m_goal;
+  int numIterations;
+  int solutionCost;
+
+private:
+  struct WorkerArg
+  {
+    ParallelIDA * self;
+    int           id;
+  };
+
+#ifdef USE_WORK_STEALING
+  // Explicit depth first search stack of a worker
+  struct WorkerStack
+  {
+    SearchState   root;					// root of the work item being searched
+    std::vector<Operator> rootPath;	// operators from the start to the root
+    int           rootHeuristic;	// heuristic of the root's parent (for BPMX)
+    DfsFrame      frames[MAX_COST+1];
+    volatile int  stealRequested;	// set by an idle worker that wants work
+    bool          busy;
+    int           nextVictim;			// first worker this one asks for work when idle
+  };
+#endif
+
+  const int numThreads;
+  std::vector<IDA*> workers;
+  std::vector<pthread_t> threads;
+  std::vector<WorkerArg> workerArgs;
+  pthread_barrier_t startBarrier;
+  pthread_barrier_t doneBarrier;
+  bool shutdown;
+
+  // Work for the current iteration.
+  // With USE_WORK_STEALING this is the pool of stolen work items.
+  std::vector<FrontierNode> frontier;
+  int costLimit;
+  volatile int nextFrontierNode;
+  volatile bool solutionFound;
+  int solutionThread;
+  std::vector<Operator> path;	// operators from the start to the node being split
+  SearchResult result;
+
+#ifdef USE_SHARED_TRANS_TABLE
+  SharedTransTable * sharedTransTable;
+  bool useSharedTransTable;
+#endif
+
+#ifdef USE_WORK_STEALING
+  std::vector<WorkerStack> stacks;
+  pthread_mutex_t workMutex;			// protects frontier and the members below
+  pthread_cond_t workCond;
+  int numIdle;
+  long long numSteals;
+#endif
+
+public:
+#ifdef USE_PERIMETER_DB
+  ParallelIDA(const PerimeterDb & perimeterDb, const int _numThreads = NUM_THREADS);
+#else
+  ParallelIDA(const int _numThreads = NUM_THREADS);
+#endif
+  ~ParallelIDA();
+
+  // Main search function
+  int search(const SearchState & start, const SearchState & goal);
+  long long getNodesGenerated() const;
+  long long getNodesGenerated(const int thread) const { return workers[thread]->generationCount; }
+  int getNumThreads() const { return numThreads; }
+  int getIterations() const { return numIterations; }
+  // The outcome of the last search, including the path from the start to the goal
+  const SearchResult & getResult() const { return result; }
+  void printThreadInfo(LogLevel level) const;
+#ifdef USE_TRANS_TABLE
+  // Probe counters of the last search, summed over all workers
+  TransTableStats getTransTableStats() const;
+  double percentFull() const;
+#endif
+#ifdef USE_SHARED_TRANS_TABLE
+  // Choose between one shared table (the default) and a table per worker
+  void setSharedTransTable(const bool share);
+#endif
+
+private:
+  void startThreads();
+  static void * workerMain( void * arg );
+  void runWorker( const int id );
+
+#ifndef USE_WORK_STEALING
+  // Expands the tree down to the split depth and fills the frontier.
+  // returns SEARCH_FOUND_SOLUTION if the goal is above the split depth.
+  NodeStatus splitRecursive( SearchState & state, const int & costLimit, int & prevHeuristic, const int & depth );
+#else
+  // Blocks until a work item is available.
+  // returns false when the iteration is over (no work left anywhere, or solution found).
+  bool takeWork( const int id, FrontierNode & item );
+  // Hands the untried children on the shallowest level of the stack to the work pool.
+  void donateWork( const int id, const int & depth );
+  // Same as IDA::idaRecursive, but with an explicit stack that can be split.
+  NodeStatus stealingDfs( const int id, const FrontierNode & item );
+#endif
+};
+
+#include "parallelSearch.hpp"
+
+#endif	// PARALLEL_SEARCH_H
+#endif	// USE_PARALLEL_IDA
@@ -0,0 +1,650 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+////////////////////////////////
+// Parallel IDA star search ////
+////////////////////////////////
+
+#ifdef USE_PERIMETER_DB
+ParallelIDA::ParallelIDA(const PerimeterDb & perimeterDb, const int _numThreads)
+#else
+ParallelIDA::ParallelIDA(const int _numThreads)
+#endif
+: generationCount(0), numIterations(0), solutionCost(-1), numThreads(_numThreads), shutdown(false),
+  costLimit(0), nextFrontierNode(0), solutionFound(false), solutionThread(-1)
+{
+  for( int i=0; i<numThreads; i++ )
+  {
+#ifdef USE_PERIMETER_DB
+    IDA * ida = new IDA(perimeterDb);
+#else
+    IDA * ida = new IDA();
+#endif
+    ida->abortSearch = &solutionFound;
+    workers.push_back(ida);
+  }
+#ifdef USE_SHARED_TRANS_TABLE
+  // As much memory as all the per-thread tables together
+#ifdef USE_RUNTIME_TABLE_SIZE
+  sharedTransTable = new SharedTransTable(numThreads*(g_transTableBytes/sizeof(SharedTransTableEntry)));
+#else
+  sharedTransTable = new SharedTransTable(numThreads*TT_SIZE);
+#endif
+  setSharedTransTable(true);
+#endif
+#ifdef USE_WORK_STEALING
+  stacks.resize(numThreads);
+  pthread_mutex_init(&workMutex, NULL);
+  pthread_cond_init(&workCond, NULL);
+  numIdle = numThreads;
+  numSteals = 0;
+#endif
+  startThreads();
+}
+
+ParallelIDA::~ParallelIDA()
+{
+  // Wake up the workers and let them exit
+  shutdown = true;
+  pthread_barrier_wait(&startBarrier);
+  for( int i=0; i<numThreads; i++ )
+  {
+    pthread_join(threads[i], NULL);
+    delete workers[i];
+  }
+  pthread_barrier_destroy(&startBarrier);
+  pthread_barrier_destroy(&doneBarrier);
+#ifdef USE_SHARED_TRANS_TABLE
+  delete sharedTransTable;
+#endif
+#ifdef USE_WORK_STEALING
+  pthread_mutex_destroy(&workMutex);
+  pthread_cond_destroy(&workCond);
+#endif
+}
+
+inline void ParallelIDA::startThreads()
+{
+  // The calling thread takes part in both barriers
+  pthread_barrier_init(&startBarrier, NULL, numThreads+1);
+  pthread_barrier_init(&doneBarrier, NULL, numThreads+1);
+  threads.resize(numThreads);
+  workerArgs.resize(numThreads);
+  for( int i=0; i<numThreads; i++ )
+  {
+    workerArgs[i].self = this;
+    workerArgs[i].id = i;
+    if( pthread_create(&threads[i], NULL, workerMain, &workerArgs[i]) != 0 )
+    {
+      LOG_ERROR("Could not create worker thread %i\n", i);
+      exit(1);
+    }
+  }
+}
+
+void * ParallelIDA::workerMain( void * arg )
+{
+  WorkerArg * workerArg = (WorkerArg*)arg;
+  workerArg->self->runWorker(workerArg->id);
+  return NULL;
+}
+
+// Each worker sleeps until an iteration starts,
+// then takes subtrees off the frontier until none are left
+// or a solution has been found by any thread.
+inline void ParallelIDA::runWorker( const int id )
+{
+#ifndef USE_WORK_STEALING
+  IDA & ida = *workers[id];
+#endif
+  while( true )
+  {
+    pthread_barrier_wait(&startBarrier);
+    if( shutdown )
+    {
+      break;
+    }
+
+#ifdef USE_WORK_STEALING
+    FrontierNode item;
+    while( takeWork(id, item) )
+    {
+      if( stealingDfs(id, item) == SEARCH_FOUND_SOLUTION )
+      {
+        IDA & ida = *workers[id];
+        ida.path.insert( ida.path.end(), item.path.rbegin(), item.path.rend() );
+        pthread_mutex_lock(&workMutex);
+        solutionThread = id;
+        solutionFound = true;
+        pthread_cond_broadcast(&workCond);
+        pthread_mutex_unlock(&workMutex);
+      }
+    }
+#else
+    while( !solutionFound )
+    {
+      const int i = __sync_fetch_and_add(&nextFrontierNode, 1);
+      if( i >= (int)frontier.size() )
+      {
+        break;
+      }
+      SearchState state = frontier[i].state;
+      int heur = frontier[i].prevHeuristic;
+#ifdef USE_ITERATIVE_IDA
+      if( ida.idaIterative(state, costLimit, heur) == SEARCH_FOUND_SOLUTION )
+#else
+      if( ida.idaRecursive(state, costLimit, heur) == SEARCH_FOUND_SOLUTION )
+#endif
+      {
+        // ida.path is built backwards, from the goal to the frontier node
+        const std::vector<Operator> & prefix = frontier[i].path;
+        ida.path.insert( ida.path.end(), prefix.rbegin(), prefix.rend() );
+        solutionThread = id;
+        solutionFound = true;
+      }
+    }
+#endif
+
+    pthread_barrier_wait(&doneBarrier);
+  }
+}
+
+inline long long ParallelIDA::getNodesGenerated() const
+{
+  long long total = generationCount;
+  for( int i=0; i<numThreads; i++ )
+  {
+    total += workers[i]->generationCount;
+  }
+  return total;
+}
+
+#ifdef USE_SHARED_TRANS_TABLE
+inline void ParallelIDA::setSharedTransTable(const bool share)
+{
+  useSharedTransTable = share;
+  for( int i=0; i<numThreads; i++ )
+  {
+    workers[i]->sharedTransTable = share ? sharedTransTable : NULL;
+  }
+}
+#endif
+
+#ifdef USE_TRANS_TABLE
+inline TransTableStats ParallelIDA::getTransTableStats() const
+{
+  TransTableStats stats;
+  for( int i=0; i<numThreads; i++ )
+  {
+    TransTableStats threadStats = workers[i]->transTable.stats;
+#ifdef USE_SHARED_TRANS_TABLE
+    if( useSharedTransTable )
+    {
+      threadStats = workers[i]->sharedTransTableStats;
+    }
+#endif
+    stats.probes += threadStats.probes;
+    stats.hits += threadStats.hits;
+#ifdef USE_TT_L1
+    stats.l1Hits += threadStats.l1Hits;
+#endif
+  }
+  return stats;
+}
+
+inline double ParallelIDA::percentFull() const
+{
+#ifdef USE_SHARED_TRANS_TABLE
+  if( useSharedTransTable )
+  {
+    return sharedTransTable->percentFull();
+  }
+#endif
+  return workers[0]->transTable.percentFull();
+}
+#endif
+
+inline void ParallelIDA::printThreadInfo(LogLevel level) const
+{
+  _LOG(level, "threads=%i split genCnt=%13lld", numThreads, generationCount);
+#ifdef USE_WORK_STEALING
+  _LOG(level, " steals=%9lld", numSteals);
+#endif
+  if( solutionThread >= 0 )
+  {
+    _LOG(level, " solutionThread=%i", solutionThread);
+  }
+  _LOG(level, "\n");
+  for( int i=0; i<numThreads; i++ )
+  {
+    _LOG(level, "thread=%2i genCnt=%13lld", i, workers[i]->generationCount);
+#ifdef USE_TRANS_TABLE
+    TransTableStats stats = workers[i]->transTable.stats;
+#ifdef USE_SHARED_TRANS_TABLE
+    if( useSharedTransTable )
+    {
+      stats = workers[i]->sharedTransTableStats;
+    }
+#endif
+    _LOG(level, " ttProbes=%13lld ttHitRate=%.3f", stats.probes, stats.hitRate());
+#endif
+    _LOG(level, "\n");
+  }
+}
+
+#ifndef USE_WORK_STEALING
+// Same as IDA::idaRecursive without the transposition table,
+// except that nodes at the split depth are collected instead of searched.
+NodeStatus ParallelIDA::splitRecursive( SearchState & state, const int & costLimit, int & prevHeuristic, const int & depth )
+{
+  if( depth == PARALLEL_SPLIT_DEPTH )
+  {
+    FrontierNode node;
+    node.state = state;
+    node.prevHeuristic = prevHeuristic;
+    node.path = path;
+    frontier.push_back(node);
+    return SEARCH_SOME_CHILDREN_LEAF;
+  }
+
+  generationCount++;
+
+  // find heuristic
+  IDA & ida = *workers[0];
+  int heuristic = ida.getHeuristic(state);
+#ifdef USE_BPMX
+  heuristic = std::max(prevHeuristic-1,heuristic);
+  prevHeuristic = std::max(prevHeuristic, heuristic-1);
+#endif
+
+  if( state.cost + heuristic > costLimit )
+  {
+    ida.recordOverflow(state.cost + heuristic);
+    return SEARCH_SOME_CHILDREN_LEAF;
+  }
+
+  if( state == m_goal )
+  {
+    solutionCost = state.cost;
+    return SEARCH_FOUND_SOLUTION;
+  }
+
+  const OpList opList = state.findSuccessorOperators();
+  for( int i=0; i<opList.length; i++ )
+  {
+    state.apply( opList.ops[i] );
+    path.push_back( opList.ops[i] );
+    NodeStatus status = splitRecursive( state, costLimit, heuristic, depth+1 );
+    state.unapply( opList.ops[i] );
+
+    if( status == SEARCH_FOUND_SOLUTION )
+    {	// path leads from the start to the goal
+      return SEARCH_FOUND_SOLUTION;
+    }
+    path.pop_back();
+  }
+
+  return SEARCH_SOME_CHILDREN_LEAF;
+}
+
+#else
+
+inline bool ParallelIDA::takeWork( const int id, FrontierNode & item )
+{
+  WorkerStack & stack = stacks[id];
+  pthread_mutex_lock(&workMutex);
+  if( stack.busy )
+  {	// finished the previous work item
+    stack.busy = false;
+    stack.stealRequested = 0;
+    numIdle++;
+    pthread_cond_broadcast(&workCond);
+  }
+
+  while( true )
+  {
+    if( solutionFound )
+    {
+      break;
+    }
+    if( !frontier.empty() )
+    {
+      item = frontier.back();
+      frontier.pop_back();
+      stack.busy = true;
+      numIdle--;
+      break;
+    }
+    if( numIdle == numThreads )
+    {	// Nobody is searching and there is nothing left to steal.
+      break;
+    }
+
+    // Ask a busy worker to split its stack. Start after the last worker
+    // asked, so the requests rotate over all busy workers, and skip workers
+    // that still have a request pending: they have nothing to give yet.
+    for( int i=0; i<numThreads; i++ )
+    {
+      const int victim = (stack.nextVictim+i)%numThreads;
+      if( victim != id && stacks[victim].busy && !stacks[victim].stealRequested )
+      {
+        stacks[victim].stealRequested = 1;
+        stack.nextVictim = (victim+1)%numThreads;
+        break;
+      }
+    }
+    pthread_cond_wait(&workCond, &workMutex);
+  }
+
+  const bool foundWork = stack.busy;
+  pthread_mutex_unlock(&workMutex);
+  return foundWork;
+}
+
+// Called by the busy worker itself, so the stack can't change underneath us.
+inline void ParallelIDA::donateWork( const int id, const int & depth )
+{
+  WorkerStack & stack = stacks[id];
+
+  // Find the shallowest level with untried children
+  int level = 0;
+  while( level < depth && stack.frames[level].next >= stack.frames[level].opList.length )
+  {
+    level++;
+  }
+  if( level == depth )
+  {	// Nothing to give yet. Leave the request pending, so the thief asks
+    // somebody else and we donate as soon as we have untried children.
+    return;
+  }
+
+  pthread_mutex_lock(&workMutex);
+  // Rebuild the node on that level, and the path to it, from the root of the work item
+  DfsFrame & frame = stack.frames[level];
+  SearchState state = stack.root;
+  std::vector<Operator> statePath = stack.rootPath;
+  for( int i=0; i<level; i++ )
+  {
+    const DfsFrame & f = stack.frames[i];
+    state.apply( f.opList.ops[f.next-1] );
+    statePath.push_back( f.opList.ops[f.next-1] );
+  }
+
+  // Give the untried children away
+  for( int i=frame.next; i<frame.opList.length; i++ )
+  {
+    FrontierNode node;
+    node.state = state;
+    node.state.apply( frame.opList.ops[i] );
+    node.prevHeuristic = frame.heuristic;
+    node.path = statePath;
+    node.path.push_back( frame.opList.ops[i] );
+    frontier.push_back(node);
+  }
+  // ...and never search them here.
+  frame.opList.length = frame.next;
+  numSteals++;
+  stack.stealRequested = 0;
+  pthread_cond_broadcast(&workCond);
+  pthread_mutex_unlock(&workMutex);
+}
+
+// The node and BPMX handling is the same as in IDA::idaRecursive.
+// The path to the current node is kept in stack.frames, where frames[d]
+// belongs to the node at depth d, and frames[d].opList.ops[frames[d].next-1]
+// is the operator that leads to the node at depth d+1.
+// Children given away by donateWork() are not reported back to their parent,
+// so the parent can't use their status or heuristic for BPMX.
+inline NodeStatus ParallelIDA::stealingDfs( const int id, const FrontierNode & item )
+{
+  IDA & ida = *workers[id];
+  WorkerStack & stack = this->stacks[id];
+  DfsFrame * frames = stack.frames;
+  stack.root = item.state;
+  stack.rootPath = item.path;
+  stack.rootHeuristic = item.prevHeuristic;
+  SearchState state = item.state;
+  NodeStatus status;
+  int depth = 0;
+
+  while( true )
+  {
+    if( solutionFound )
+    {	// another thread finished the iteration.
+      return SEARCH_SOME_CHILDREN_LEAF;
+    }
+    if( stack.stealRequested )
+    {
+      donateWork(id, depth);
+    }
+
+    // Generate the node at 'depth'
+    ida.generationCount++;
+    int & prevHeuristic = (depth == 0) ? stack.rootHeuristic : frames[depth-1].heuristic;
+    NodeVisit & visit = frames[depth].visit;
+    ida.startVisit(state, visit);
+    int heuristic = ida.getHeuristic(state, visit, costLimit, prevHeuristic);
+#ifdef USE_HEURISTIC_UPDATES
+    ida.checkHeuristic(state, heuristic, visit);
+#endif
+
+    PruneStatus pruneStatus = ida.prune(state,costLimit,heuristic,visit);
+    if( pruneStatus == NODE_PRUNED_BY_TT )
+    {
+      status = SEARCH_NODE_IN_TT;
+    }
+    else if( pruneStatus == NODE_PRUNED_BY_COST )
+    {
+      status = SEARCH_SOME_CHILDREN_LEAF;
+    }
+    else
+    {
+      if( state == ida.m_goal )
+      {
+        ida.solutionCost = state.cost;
+        // Backwards from the goal to the root of the work item, like IDA::idaIterative
+        ida.path.clear();
+        for( int d=depth-1; d>=0; d-- )
+        {
+          ida.path.push_back( frames[d].opList.ops[frames[d].next-1] );
+        }
+        return SEARCH_FOUND_SOLUTION;
+      }
+
+      // Expand
+      DfsFrame & frame = frames[depth];
+      frame.opList = state.findSuccessorOperators();
+      frame.next = 0;
+      ida.prefetchChildren(state, frame.opList);
+      frame.heuristic = heuristic;
+      frame.childrenStatus = SEARCH_ALL_CHILDREN_IN_TT;
+      if( frame.next < frame.opList.length )
+      {
+        state.apply( frame.opList.ops[frame.next++] );
+        depth++;
+        continue;
+      }
+      status = frame.childrenStatus;
+    }
+
+    // Return the status to the parents, until one of them has another child to search.
+    while( true )
+    {
+      if( depth == 0 )
+      {
+        return status;
+      }
+      depth--;
+      DfsFrame & frame = frames[depth];
+      state.unapply( frame.opList.ops[frame.next-1] );
+
+      if( status == SEARCH_SOME_CHILDREN_LEAF )
+      {
+        frame.childrenStatus = SEARCH_SOME_CHILDREN_LEAF;
+      }
+#ifdef USE_HEURISTIC_UPDATES
+      ida.checkHeuristic(state, frame.heuristic, frame.visit);
+#endif
+#ifdef USE_BPMX
+      if( state.cost + frame.heuristic > costLimit )
+      {	// heuristic propogated backwards and caused a parental cutoff
+        ida.recordOverflow(state.cost + frame.heuristic);
+        int & parentHeuristic = (depth == 0) ? stack.rootHeuristic : frames[depth-1].heuristic;
+        parentHeuristic = std::max(parentHeuristic, frame.heuristic-1);
+        status = SEARCH_SOME_CHILDREN_LEAF;
+        continue;
+      }
+#endif
+
+      if( frame.next < frame.opList.length )
+      {
+        state.apply( frame.opList.ops[frame.next++] );
+        depth++;
+        break;
+      }
+      status = frame.childrenStatus;
+    }
+  }
+}
+
+#endif
+
+inline int ParallelIDA::search(const SearchState & start, const SearchState & goal)
+{
+  int depth = 0;
+  generationCount = 0;
+  numIterations = 0;
+  solutionCost = -1;
+  solutionThread = -1;
+  path.clear();
+  result.clear();
+  m_goal = goal;
+  for( int i=0; i<numThreads; i++ )
+  {
+    IDA & ida = *workers[i];
+    ida.generationCount = 0;
+#ifdef USE_HEURISTIC_CACHE
+    if( !(goal == ida.m_goal) )
+    {	// The cached values are distances to the old goal
+      ida.heuristicCache.clear();
+    }
+    ida.heuristicCache.stats.reset();
+#endif
+    ida.m_goal = goal;
+#ifdef USE_TRANS_TABLE
+    ida.transTable.reset();
+#endif
+#ifdef USE_SHARED_TRANS_TABLE
+    ida.sharedTransTableStats.reset();
+#endif
+  }
+#ifdef USE_SHARED_TRANS_TABLE
+  if( useSharedTransTable )
+  {
+    sharedTransTable->reset();
+  }
+#endif
+
+  // No solution can be cheaper than the heuristic of the start state
+  depth = workers[0]->getHeuristic(start);
+  long long lastNodeCount = 0;
+
+  const double startTime = getWallTime();
+  double lastTime = 0.0;
+  NodeStatus status = SEARCH_SOME_CHILDREN_LEAF;
+  SearchState state;
+  while( status != SEARCH_FOUND_SOLUTION && depth < MAX_COST )
+  {
+    state = start;
+    numIterations++;
+    for( int i=0; i<numThreads; i++ )
+    {
+      workers[i]->resetOverflow();
+    }
+
+    // Split
+    frontier.clear();
+#ifdef USE_WORK_STEALING
+    // Start with a single work item. The workers split it up between themselves.
+    FrontierNode root;
+    root.state = state;
+    root.prevHeuristic = 0;
+    root.path.clear();
+    frontier.push_back(root);
+    numIdle = numThreads;
+    numSteals = 0;
+    for( int i=0; i<numThreads; i++ )
+    {
+      stacks[i].busy = false;
+      stacks[i].stealRequested = 0;
+      stacks[i].nextVictim = (i+1)%numThreads;
+    }
+#else
+    int heur = 0;
+    status = splitRecursive(state, depth, heur, 0);
+#endif
+
+    // Search the subtrees in parallel
+    if( status != SEARCH_FOUND_SOLUTION && !frontier.empty() )
+    {
+      costLimit = depth;
+      nextFrontierNode = 0;
+      solutionFound = false;
+      solutionThread = -1;
+      pthread_barrier_wait(&startBarrier);
+      pthread_barrier_wait(&doneBarrier);
+      if( solutionFound )
+      {
+        status = SEARCH_FOUND_SOLUTION;
+        solutionCost = workers[solutionThread]->solutionCost;
+      }
+    }
+
+    const double time = getWallTime() - startTime;
+    const long long nodes = getNodesGenerated();
+#ifdef USE_TRANS_TABLE
+    const double ttFill = percentFull();
+#else
+    const double ttFill = -1.0;
+#endif
+    result.addIteration( depth, nodes - lastNodeCount, time - lastTime, ttFill );
+    lastTime = time;
+
+    if( status != SEARCH_FOUND_SOLUTION )
+    {
+      for( int i=1; i<numThreads; i++ )
+      {
+        workers[0]->mergeOverflow(*workers[i]);
+      }
+      depth = workers[0]->nextCostLimit(nodes - lastNodeCount);
+      lastNodeCount = nodes;
+    }
+  }
+
+  result.nodesGenerated = getNodesGenerated();
+  result.time = getWallTime() - startTime;
+#ifdef USE_TRANS_TABLE
+  result.ttStats = getTransTableStats();
+#endif
+
+  // If didn't find solution, then we went up to our maximum depth.  May want to increase MAX_DEPTH.
+  if( status != SEARCH_FOUND_SOLUTION)
+    return -1;
+
+  if( solutionThread >= 0 )
+  {	// The worker's path is built backwards, and includes the path to its work item
+    const std::vector<Operator> & workerPath = workers[solutionThread]->path;
+    path.assign( workerPath.rbegin(), workerPath.rend() );
+  }
+  result.solutionLength = solutionCost;
+  result.path = path;
+  return solutionCost;
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_BFS_PERIMETER
+
+#ifndef PERIMETER_BFS_H
+#define PERIMETER_BFS_H
+
+#include "common.h"
+#include "domain.h"
+#include "searchState.h"
+#include "perimeterDB.h"
+#include <vector>
+
+// A state in one of the layers, with the operator that leads from it back towards the goal
+struct PerimeterNode
+{
+  State         state;
+  Operator      toGoalOp;
+};
+
+// Orders the nodes by state, and the nodes of one state by operator,
+// so that the first node of a state has the lowest operator.
+struct PerimeterNodeLess
+{
+  bool operator()( const PerimeterNode & a, const PerimeterNode & b ) const
+  {
+    const int order = memcmp(&a.state, &b.state, sizeof(State));
+    return order < 0 || ( order == 0 && a.toGoalOp < b.toGoalOp );
+  }
+};
+
+// Builds the PerimeterDb with a breadth-first search from the goal.
+// Replaces DFS: every layer (all states with the same distance to the goal)
+// is generated once, instead of once per iteration.
+// The layers are kept in memory as sorted arrays.  A new layer is sorted,
+// and duplicates are dropped by merging it with the two previous layers.
+// Only unit cost operators and undirected state spaces are supported,
+// so a duplicate can't be further back than two layers.
+// Every layer is added to the PerimeterDb once it is complete, with its exact distance.
+class PerimeterBFS
+{
+public:
+  long long generationCount;
+  PerimeterDb & perimeterDb;
+
+private:
+  long long numStates;		// states in the layers, before they are added to the PerimeterDb
+  std::vector<PerimeterNode> previous;
+  std::vector<PerimeterNode> current;
+  std::vector<PerimeterNode> next;
+
+public:
+  PerimeterBFS(PerimeterDb & _perimeterDb);
+
+  // Main search function
+  // Adds all the states less than depth away from the goal
+  void search(const SearchState & goal, const int & depth);
+  long long getNodesGenerated() { return generationCount; }
+  long long getNumStates() const { return numStates; }
+
+private:
+  // Generates the next layer from the current one
+  void expandLayer();
+  // Sorts the next layer, and removes duplicates and states in the current or previous layer
+  void removeDuplicates();
+  // Adds the current layer to the PerimeterDb
+  void addLayer( const int & distance, const int & iteration );
+};
+
+#include "perimeterBFS.hpp"
+
+#endif	// PERIMETER_BFS_H
+#endif	// USE_BFS_PERIMETER
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#include <algorithm>
+
+PerimeterBFS::PerimeterBFS(PerimeterDb & _perimeterDb) : generationCount(0), perimeterDb(_perimeterDb), numStates(0)
+{}
+
+inline void PerimeterBFS::search( const SearchState & goal, const int & depth )
+{
+  LOG("Populating PerimeterDb breadth-first\n");
+  previous.clear();
+  current.clear();
+  PerimeterNode node;
+  node.state = goal.state;
+  node.toGoalOp = NO_OP;
+  current.push_back(node);
+  generationCount++;
+
+  // DFS leaves every entry with the last iteration, so the entries are the same
+  const int iteration = depth-1;
+  for( int d=0; d<depth && !current.empty(); ++d )
+  {
+    addLayer( d, iteration );
+    LOG("\n");
+    printTime(NORMAL);
+    LOG("depth=%3.i layer=%lu ", d, (unsigned long)current.size());
+    perimeterDb.printInfo(NORMAL);
+    perimeterDb.printHistogram(DEBUG,d);
+
+    if( d+1 < depth )
+    {
+      expandLayer();
+      removeDuplicates();
+      previous.swap(current);
+      current.swap(next);
+    }
+  }
+  previous.clear();
+  current.clear();
+  next.clear();
+}
+
+inline void PerimeterBFS::expandLayer()
+{
+  next.clear();
+  for( unsigned int i=0; i<current.size(); i++ )
+  {
+    SearchState parent;
+    parent.state = current[i].state;
+    parent.init();
+    const OpList opList = parent.findPredecessorOperators();
+    for( int j=0; j<opList.length; j++ )
+    {
+      SearchState child = parent;
+      child.apply( opList.ops[j] );
+      generationCount++;
+
+      PerimeterNode node;
+      node.state = child.state;
+      node.toGoalOp = reverse(opList.ops[j]);
+      next.push_back(node);
+    }
+  }
+}
+
+inline void PerimeterBFS::removeDuplicates()
+{
+  std::sort(next.begin(), next.end(), PerimeterNodeLess());
+
+  // The current and previous layers are sorted too, so they are walked alongside
+  const std::vector<PerimeterNode> * layers[2] = { &current, &previous };
+  unsigned int layerIndex[2] = { 0, 0 };
+  unsigned int length = 0;
+  for( unsigned int i=0; i<next.size(); i++ )
+  {
+    // duplicate within the new layer.  The first one has the lowest operator.
+    if( i > 0 && next[i].state == next[i-1].state )
+    {
+      continue;
+    }
+
+    // duplicate of the previous layers
+    bool duplicate = false;
+    for( int l=0; l<2; l++ )
+    {
+      const std::vector<PerimeterNode> & layer = *layers[l];
+      unsigned int & j = layerIndex[l];
+      while( j < layer.size() && memcmp(&layer[j].state, &next[i].state, sizeof(State)) < 0 )
+      {
+        j++;
+      }
+      if( j < layer.size() && layer[j].state == next[i].state )
+      {
+        duplicate = true;
+      }
+    }
+    if( !duplicate )
+    {
+      next[length++] = next[i];
+    }
+  }
+  next.resize(length);
+}
+
+inline void PerimeterBFS::addLayer( const int & distance, const int & iteration )
+{
+  Hash hash;
+  for( unsigned int i=0; i<current.size(); i++ )
+  {
+    hash.calculateHash(current[i].state);
+    perimeterDb.pruneState( current[i].state, hash, distance, iteration, current[i].toGoalOp );
+  }
+  numStates += current.size();
+}
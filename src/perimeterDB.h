@@ -14,6 +14,18 @@
 
 #include "common.h"
 #include "domain.h"
+#include "tableMemory.h"
+#include "frozenPerimeter.h"
+#include <string.h>
+#ifdef USE_PERIMETER_FILE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 class PerimeterDbEntry
 {
@@ -26,45 +38,125 @@ public:
 #ifdef USE_PERIMETER_STATE_PRIORITIZATION
   unsigned int	priority;
 #endif
+#ifdef USE_PERIMETER_SEARCH
+  Operator      toGoalOp;		// first operator on a shortest path to the goal
+#endif
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  int           probe;		// number of slots past the home slot of the state
+#endif
 
 public:
   PerimeterDbEntry();
   ~PerimeterDbEntry();
-  bool updateEntry(const int & cost, const int & iteration);
+  bool updateEntry(const int & cost, const int & iteration, const Operator & toGoalOp);
+#ifdef USE_PERIMETER_STATE_PRIORITIZATION
+  // returns true if a state with the given priority takes the entry over
+  bool losesTo(const State & state, const unsigned int & priority) const;
+#endif
+#ifdef USE_PERIMETER_SEARCH
+  void keepLowestOp(const Operator & toGoalOp);
+#endif
   void print(LogLevel level) const;
 };
 
 class PerimeterDb
 {
 private:
+#ifdef USE_RUNTIME_TABLE_SIZE
+  TableMemory<PerimeterDbEntry> perimeterDb;
+  size_t indexMask;		// number of entries - 1
+#else
   PerimeterDbEntry * perimeterDb;
+#endif
   double avgDepth;
+#ifdef USE_PARALLEL_PERIMETER
+  // Held while pruneState reads and writes an entry, so that threads can fill the PerimeterDb together
+  volatile int locks[PERIMETER_LOCK_STRIPES];
+#endif
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  long long numDropped;		// states that didn't fit within PERIMETER_MAX_PROBE slots
+#endif
+#ifdef USE_FROZEN_PERIMETER
+  FrozenPerimeterDb * frozen;	// set by freeze, after which the entries are gone
+#endif
+#ifdef USE_PERIMETER_FILE
+  bool mapped;				// true if perimeterDb is a mapped file
+#ifndef USE_RUNTIME_TABLE_SIZE
+  void * mapping;
+  size_t mappingBytes;
+#endif
+#endif
 
 public:
-  PerimeterDb() { perimeterDb = new PerimeterDbEntry[PERIMETER_DB_SIZE];}
-  ~PerimeterDb() { delete[] perimeterDb; }
+  PerimeterDb();
+#ifdef USE_PERIMETER_FILE
+  // Maps the file if it holds a PerimeterDb built for this goal and depth,
+  // otherwise allocates an empty one.  A mapped PerimeterDb is read-only.
+  PerimeterDb(const char * filename, const State & goal, const int & depth);
+  bool isMapped() const;
+  // Writes the finished PerimeterDb, so that later runs can map it
+  bool save(const char * filename, const State & goal, const int & depth) const;
+#endif
+  ~PerimeterDb();
   void reset();
+  // Number of entries
+  size_t size() const;
 
   // Adds or updates the state in the trans table,
   // and returns true if the node already exists and should be pruned from the search tree.
   // returns false if the state must be expanded.
-  bool pruneState( const State & state, const Hash & hash, const int cost, const int iteration );	// TODO: reference
+  // toGoalOp is the operator that leads from the state back towards the goal.
+  bool pruneState( const State & state, const Hash & hash, const int cost, const int iteration, const Operator & toGoalOp );	// TODO: reference
   // Returns the cost to the goal state, if the state exists in the perimeterDb
   // returns 0 otherwise
   int getHeuristic( const State & state, const Hash & hash ) const;
+  // Returns the entry of the state, or NULL if the state is not in the perimeterDb
+  const PerimeterDbEntry * lookup( const State & state, const Hash & hash ) const;
+  // Starts loading the entry of the state into the cache
+  void prefetch( const Hash & hash ) const;
   // return true if a state exists at this index
   // if true, set the state and the cost
-  PerimeterDbEntry * getState( const unsigned & index );
+  PerimeterDbEntry * getState( const size_t & index );
+#ifdef USE_FROZEN_PERIMETER
+  // Replaces the entries with a FrozenPerimeterDb.
+  // Only getHeuristic and printInfo may be used afterwards.
+  // returns false, and keeps the entries, if a state was dropped by the PerimeterDb
+  // or by the perfect hash, since the frozen heuristic would no longer be admissible.
+  bool freeze();
+#endif
 
   // Stats
   void print(LogLevel level) const;
   void printInfo(LogLevel level) const;
   void printHistogram(LogLevel level, const unsigned int depth) const;
+  // generated is the number of distinct states the builder found
+  void printCoverage(LogLevel level, const long long & generated) const;
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  void printProbeHistogram(LogLevel level) const;
+#endif
   double getAvgDepth() const;
 
 private:
+  void allocate();
+#ifdef USE_PERIMETER_FILE
+  // returns false, and leaves the PerimeterDb unallocated, if the file can't be used
+  bool map(const char * filename, const State & goal, const int & depth);
+#endif
   unsigned int calculateIndex( const Hash & hash ) const;
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  unsigned int nextIndex( const unsigned int & index ) const { return (size_t)index+1 == size() ? 0 : index+1; }
+  // returns the entry of the state, or NULL
+  PerimeterDbEntry * findEntry( const State & state, const Hash & hash ) const;
+  // Places the entry at index, and moves the entries after it along the probe sequence
+  void insertEntry( unsigned int index, PerimeterDbEntry entry );
+#endif
+  // pruneState without the lock
+  bool updateState( const State & state, const Hash & hash, const int cost, const int iteration, const Operator & toGoalOp );
   void calculate(long long & numEntries, double & avgDepth, double & percentFull) const;
+
+  // Not copyable
+  PerimeterDb(const PerimeterDb &);
+  PerimeterDb & operator=(const PerimeterDb &);
 };
 
 #include "perimeterDB.hpp"
@@ -16,9 +16,13 @@
 /////////////////////////////////////
 
 #include <math.h>
+#include <algorithm>
 
 PerimeterDbEntry::PerimeterDbEntry()
 : state(), cost(MAX_COST)
+#ifdef USE_PERIMETER_ROBIN_HOOD
+, probe(0)
+#endif
 {}
 
 PerimeterDbEntry::~PerimeterDbEntry()
@@ -39,7 +43,7 @@ inline void PerimeterDbEntry::print(LogLevel level) const
 // returns true if entry was updated and the node must be expanded.
 // returns false if the node has been visited previously
 // and doesn't need expanding
-inline bool PerimeterDbEntry::updateEntry(const int & cost, const int & iteration )
+inline bool PerimeterDbEntry::updateEntry(const int & cost, const int & iteration, const Operator & toGoalOp )
 {
 
 #ifdef USE_LAZY_PERIMETER
@@ -58,11 +62,17 @@ inline bool PerimeterDbEntry::updateEntry(const int & cost, const int & iteratio
     {
       // Reached on this iteration.  Prune.
       //LOG("pruned by TT\n");
+#ifdef USE_PERIMETER_SEARCH
+      keepLowestOp( toGoalOp );
+#endif
       return false;
     } else {
       // reached on previous iteration.
       // Update the cost, but do not prune.
       this->iteration = iteration;
+#ifdef USE_PERIMETER_SEARCH
+      keepLowestOp( toGoalOp );
+#endif
       return true;
     }
   }
@@ -82,6 +92,9 @@ inline bool PerimeterDbEntry::updateEntry(const int & cost, const int & iteratio
     this->cost = cost;
 #ifdef USE_LAZY_PERIMETER
     this->iteration = iteration;
+#endif
+#ifdef USE_PERIMETER_SEARCH
+    this->toGoalOp = toGoalOp;
 #endif
     //LOG("set cost=%d costLimit=%d\n", cost, costLimit);
     return true;
@@ -90,14 +103,274 @@ inline bool PerimeterDbEntry::updateEntry(const int & cost, const int & iteratio
   return true;
 }
 
+#ifdef USE_PERIMETER_SEARCH
+// Of the operators on equally short paths, keep the lowest,
+// so the stored path doesn't depend on which path was searched first.
+inline void PerimeterDbEntry::keepLowestOp( const Operator & toGoalOp )
+{
+  if( toGoalOp < this->toGoalOp )
+  {
+    this->toGoalOp = toGoalOp;
+  }
+}
+#endif
+
+#ifdef USE_PERIMETER_STATE_PRIORITIZATION
+// Ties are broken by the state, so the entry ends up with the same state
+// whatever order the states are added in.
+inline bool PerimeterDbEntry::losesTo( const State & state, const unsigned int & priority ) const
+{
+  return priority > this->priority
+    || ( priority == this->priority && memcmp(&state, &this->state, sizeof(State)) < 0 );
+}
+#endif
+
 /////////////////////////////////////
 // PerimeterDb///////////////////////
 /////////////////////////////////////
 
+inline PerimeterDb::PerimeterDb()
+{
+  allocate();
+}
+
+#ifdef USE_RUNTIME_TABLE_SIZE
+inline void PerimeterDb::allocate()
+{
+  perimeterDb.allocate( tableEntries(g_perimeterDbBytes, sizeof(PerimeterDbEntry)) );
+  indexMask = perimeterDb.size() - 1;
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  numDropped = 0;
+#endif
+#ifdef USE_FROZEN_PERIMETER
+  frozen = NULL;
+#endif
+#ifdef USE_PERIMETER_FILE
+  mapped = false;
+#endif
+#ifdef USE_PARALLEL_PERIMETER
+  memset( (void*)locks, 0, sizeof(locks) );
+#endif
+}
+
+inline PerimeterDb::~PerimeterDb()
+{
+#ifdef USE_FROZEN_PERIMETER
+  delete frozen;
+#endif
+}
+
+inline size_t PerimeterDb::size() const
+{
+  return indexMask + 1;
+}
+#else
+inline void PerimeterDb::allocate()
+{
+  perimeterDb = new PerimeterDbEntry[PERIMETER_DB_SIZE];
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  numDropped = 0;
+#endif
+#ifdef USE_FROZEN_PERIMETER
+  frozen = NULL;
+#endif
+#ifdef USE_PERIMETER_FILE
+  mapped = false;
+  mapping = NULL;
+  mappingBytes = 0;
+#endif
+#ifdef USE_PARALLEL_PERIMETER
+  memset( (void*)locks, 0, sizeof(locks) );
+#endif
+}
+
+inline PerimeterDb::~PerimeterDb()
+{
+#ifdef USE_FROZEN_PERIMETER
+  delete frozen;
+#endif
+#ifdef USE_PERIMETER_FILE
+  if( mapped )
+  {
+    munmap(mapping, mappingBytes);
+    return;
+  }
+#endif
+  delete[] perimeterDb;
+}
+
+inline size_t PerimeterDb::size() const { return PERIMETER_DB_SIZE; }
+#endif
+
+#ifdef USE_PERIMETER_FILE
+// Written at the start of a saved PerimeterDb.
+// The entries start at PERIMETER_FILE_DATA_OFFSET, so that they are page aligned when mapped.
+struct PerimeterDbHeader
+{
+  char          magic[8];
+  unsigned int  version;
+  unsigned int  domain;
+  unsigned int  dimensions[2];	// width and height, or the number of pancakes
+  unsigned int  depth;
+  unsigned int  goalHash;		// Hash of the goal. Changes with the hash seed.
+  unsigned int  options;		// PERIMETER_FILE_* flags of the entry layout and index
+  unsigned int  entrySize;
+  unsigned long long size;
+  State         goal;
+};
+
+const char PERIMETER_FILE_MAGIC[8] = "PERIMDB";
+const unsigned int PERIMETER_FILE_VERSION = 1;
+const size_t PERIMETER_FILE_DATA_OFFSET = 4096;
+const unsigned int PERIMETER_FILE_LAZY = 1;
+const unsigned int PERIMETER_FILE_PRIORITIZATION = 2;
+const unsigned int PERIMETER_FILE_SEARCH = 4;
+const unsigned int PERIMETER_FILE_RUNTIME_SIZE = 8;
+const unsigned int PERIMETER_FILE_ROBIN_HOOD = 16;
+
+// The header this build writes, and expects to read
+inline void makePerimeterDbHeader( PerimeterDbHeader & header, const State & goal, const int & depth, const size_t & size )
+{
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, PERIMETER_FILE_MAGIC, sizeof(header.magic));
+  header.version = PERIMETER_FILE_VERSION;
+  header.domain = DOMAIN;
+#if DOMAIN == 1
+  header.dimensions[0] = WIDTH;
+  header.dimensions[1] = HEIGHT;
+#else
+  header.dimensions[0] = NUM_PANCAKES;
+  header.dimensions[1] = 1;
+#endif
+  header.depth = depth;
+  Hash hash;
+  hash.calculateHash(goal);
+  header.goalHash = hash.value;
+#ifdef USE_LAZY_PERIMETER
+  header.options |= PERIMETER_FILE_LAZY;
+#endif
+#ifdef USE_PERIMETER_STATE_PRIORITIZATION
+  header.options |= PERIMETER_FILE_PRIORITIZATION;
+#endif
+#ifdef USE_PERIMETER_SEARCH
+  header.options |= PERIMETER_FILE_SEARCH;
+#endif
+#ifdef USE_RUNTIME_TABLE_SIZE
+  header.options |= PERIMETER_FILE_RUNTIME_SIZE;
+#endif
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  header.options |= PERIMETER_FILE_ROBIN_HOOD;
+#endif
+  header.entrySize = sizeof(PerimeterDbEntry);
+  header.size = size;
+  header.goal = goal;
+}
+
+inline PerimeterDb::PerimeterDb(const char * filename, const State & goal, const int & depth)
+{
+  if( !map(filename, goal, depth) )
+  {
+    allocate();
+  }
+}
+
+inline bool PerimeterDb::isMapped() const
+{
+  return mapped;
+}
+
+inline bool PerimeterDb::map(const char * filename, const State & goal, const int & depth)
+{
+#ifdef USE_RUNTIME_TABLE_SIZE
+  const size_t count = tableEntries(g_perimeterDbBytes, sizeof(PerimeterDbEntry));
+#else
+  const size_t count = PERIMETER_DB_SIZE;
+#endif
+  const int fd = open(filename, O_RDONLY);
+  if( fd < 0 )
+  {
+    return false;
+  }
+  PerimeterDbHeader expected;
+  makePerimeterDbHeader(expected, goal, depth, count);
+  PerimeterDbHeader header;
+  struct stat fileStat;
+  const size_t bytes = PERIMETER_FILE_DATA_OFFSET + count*sizeof(PerimeterDbEntry);
+  if( read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)
+    || memcmp(&header, &expected, sizeof(header)) != 0
+    || fstat(fd, &fileStat) != 0
+    || (size_t)fileStat.st_size != bytes )
+  {
+    LOG_ERROR("%s doesn't match this build, building the PerimeterDb\n", filename);
+    close(fd);
+    return false;
+  }
+  // Shared, so that every process that maps the file uses the same pages
+  void * fileMapping = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if( fileMapping == MAP_FAILED )
+  {
+    return false;
+  }
+#ifdef USE_RUNTIME_TABLE_SIZE
+  perimeterDb.adopt(fileMapping, bytes, PERIMETER_FILE_DATA_OFFSET, count);
+  indexMask = count - 1;
+#else
+  mapping = fileMapping;
+  mappingBytes = bytes;
+  perimeterDb = (PerimeterDbEntry*)( (char*)mapping + PERIMETER_FILE_DATA_OFFSET );
+#endif
+  mapped = true;
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  numDropped = 0;
+#endif
+#ifdef USE_PARALLEL_PERIMETER
+  memset( (void*)locks, 0, sizeof(locks) );
+#endif
+  return true;
+}
+
+// Other processes may have the file mapped, so it is never written in place.
+// A temporary file in the same directory is written and synced, then renamed over it.
+inline bool PerimeterDb::save(const char * filename, const State & goal, const int & depth) const
+{
+  std::string tempName = std::string(filename) + ".XXXXXX";
+  const int fd = mkstemp(&tempName[0]);
+  if( fd < 0 )
+  {
+    return false;
+  }
+  fchmod(fd, 0644);
+  FILE * file = fdopen(fd, "wb");
+  if( !file )
+  {
+    close(fd);
+    unlink(tempName.c_str());
+    return false;
+  }
+  PerimeterDbHeader header;
+  makePerimeterDbHeader(header, goal, depth, size());
+  char padding[PERIMETER_FILE_DATA_OFFSET - sizeof(PerimeterDbHeader)];
+  memset(padding, 0, sizeof(padding));
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+    && fwrite(padding, sizeof(padding), 1, file) == 1
+    && fwrite(&perimeterDb[0], sizeof(PerimeterDbEntry), size(), file) == size()
+    && fflush(file) == 0
+    && fsync(fd) == 0;
+  ok = (fclose(file) == 0) && ok;
+  ok = ok && rename(tempName.c_str(), filename) == 0;
+  if( !ok )
+  {
+    unlink(tempName.c_str());
+  }
+  return ok;
+}
+#endif
+
 inline void PerimeterDb::print(LogLevel level) const
 {
   _LOG(level,"PerimeterDb= [\n");
-  for( int i=0; i<PERIMETER_DB_SIZE; i++ )
+  for( size_t i=0; i<size(); i++ )
   {
     const PerimeterDbEntry & entry = perimeterDb[i];
     if( entry.cost != MAX_COST )
@@ -109,13 +382,71 @@ inline void PerimeterDb::print(LogLevel level) const
 }
 
 inline void PerimeterDb::printInfo(LogLevel level) const
+{
+#ifdef USE_FROZEN_PERIMETER
+  if( frozen )
+  {
+    frozen->printInfo(level);
+    return;
+  }
+#endif
+  long long numEntries;
+  double percentFull;
+  double avgDepth;
+  calculate(numEntries, avgDepth, percentFull);
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  _LOG(level,"PerimeterDb: size=%lu, entries=%12lli, fill=%f avgDepth=%f dropped=%lli \n", (unsigned long)size(), numEntries, percentFull, avgDepth, numDropped);
+#else
+  _LOG(level,"PerimeterDb: size=%lu, entries=%12lli, fill=%f avgDepth=%f \n", (unsigned long)size(), numEntries, percentFull, avgDepth);
+#endif
+}
+
+inline void PerimeterDb::printCoverage(LogLevel level, const long long & generated) const
 {
   long long numEntries;
   double percentFull;
   double avgDepth;
   calculate(numEntries, avgDepth, percentFull);
-  _LOG(level,"PerimeterDb: size=%i, entries=%12lli, fill=%f avgDepth=%f \n", PERIMETER_DB_SIZE, numEntries, percentFull, avgDepth);
+  _LOG(level,"PerimeterDb: stored=%lli generated=%lli coverage=%f \n", numEntries, generated,
+    generated > 0 ? (double)numEntries/generated : 0.0);
+}
+
+#ifdef USE_PERIMETER_ROBIN_HOOD
+inline void PerimeterDb::printProbeHistogram(LogLevel level) const
+{
+  long long probe_count[PERIMETER_MAX_PROBE+1];
+  for( int i=0; i<=PERIMETER_MAX_PROBE; i++ )
+  {
+    probe_count[i] = 0;
+  }
+  long long numEntries = 0;
+  double avgProbe = 0;
+  for( size_t i=0; i<size(); i++ )
+  {
+    const PerimeterDbEntry & entry = perimeterDb[i];
+    if( entry.cost != MAX_COST )
+    {
+      probe_count[entry.probe]++;
+      numEntries++;
+      avgProbe += entry.probe;
+    }
+  }
+  if( numEntries > 0 )
+  {
+    avgProbe /= numEntries;
+  }
+
+  _LOG(level,"PerimeterDb probe histogram (avg=%f)= [\n", avgProbe);
+  for( int i=0; i<=PERIMETER_MAX_PROBE; i++ )
+  {
+    if( probe_count[i] > 0 )
+    {
+      _LOG(level,"%i:%lli ", i, probe_count[i]);
+    }
+  }
+  _LOG(level,"]\n");
 }
+#endif
 
 // TODO -- not the most efficient...  calculate is called twice...
 inline double PerimeterDb::getAvgDepth() const
@@ -146,7 +477,7 @@ inline void PerimeterDb::printHistogram(LogLevel level, const unsigned int depth
 
   // count
   Hash hash;
-  for( int i=0; i<PERIMETER_DB_SIZE; i++ )
+  for( size_t i=0; i<size(); i++ )
   {
     const PerimeterDbEntry & entry = perimeterDb[i];
     if( entry.cost != MAX_COST )
@@ -189,7 +520,7 @@ inline void PerimeterDb::printHistogram(LogLevel level, const unsigned int depth
 inline void PerimeterDb::reset()
 {
   PerimeterDbEntry entry;
-  for( int i=0; i<PERIMETER_DB_SIZE; i++)
+  for( size_t i=0; i<size(); i++)
   {
     perimeterDb[i] = entry;
   }
@@ -199,18 +530,28 @@ inline void PerimeterDb::calculate(long long & numEntries, double & avgDepth, do
 {
   numEntries = 0;
   avgDepth = 0;
-  for(int i=0; i<PERIMETER_DB_SIZE; i++) {
+  for(size_t i=0; i<size(); i++) {
     PerimeterDbEntry & entry = perimeterDb[i];
     if( entry.cost != MAX_COST ) {
       numEntries++;
       avgDepth = (avgDepth/numEntries)*(numEntries-1) + (double)entry.cost/numEntries;
     }
   }
-  percentFull = (double)numEntries/PERIMETER_DB_SIZE;
+  percentFull = (double)numEntries/size();
 }
 
 inline int PerimeterDb::getHeuristic( const State & state, const Hash & hash ) const
 {
+#ifdef USE_FROZEN_PERIMETER
+  if( frozen )
+  {
+    return frozen->getHeuristic( getSignature(state) );
+  }
+#endif
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  const PerimeterDbEntry * entry = findEntry(state, hash);
+  return entry ? entry->cost : 0;
+#else
   // Calculate index and lookup entry
   unsigned int index = calculateIndex(hash);
   PerimeterDbEntry & entry = perimeterDb[index];
@@ -222,9 +563,76 @@ inline int PerimeterDb::getHeuristic( const State & state, const Hash & hash ) c
   }
 
   return 0;
+#endif
 }
 
-inline PerimeterDbEntry * PerimeterDb::getState( const unsigned & index )
+inline const PerimeterDbEntry * PerimeterDb::lookup( const State & state, const Hash & hash ) const
+{
+#ifdef USE_PERIMETER_ROBIN_HOOD
+  return findEntry(state, hash);
+#else
+  const PerimeterDbEntry & entry = perimeterDb[calculateIndex(hash)];
+  if( entry.cost != MAX_COST && entry.state == state )
+  {
+    return &entry;
+  }
+  return NULL;
+#endif
+}
+
+inline void PerimeterDb::prefetch( const Hash & hash ) const
+{
+#ifdef USE_FROZEN_PERIMETER
+  if( frozen )
+  {
+    return;
+  }
+#endif
+  __builtin_prefetch( &perimeterDb[calculateIndex(hash)] );
+}
+
+#ifdef USE_FROZEN_PERIMETER
+inline bool PerimeterDb::freeze()
+{
+  if( numDropped > 0 )
+  {
+    LOG_ERROR("Not freezing the PerimeterDb: %lli states were dropped\n", numDropped);
+    return false;
+  }
+
+  std::vector<unsigned long long> signatures;
+  std::vector<int> distances;
+  for( size_t i=0; i<size(); i++ )
+  {
+    const PerimeterDbEntry & entry = perimeterDb[i];
+    if( entry.cost != MAX_COST )
+    {
+      signatures.push_back( getSignature(entry.state) );
+      distances.push_back( entry.cost );
+    }
+  }
+  LOG("Freezing PerimeterDb: entries=%lu bytes=%lu\n",
+    (unsigned long)signatures.size(), (unsigned long)size()*sizeof(PerimeterDbEntry));
+  FrozenPerimeterDb * index = new FrozenPerimeterDb( signatures, distances );
+  if( index->getNumDropped() > 0 )
+  {
+    LOG_ERROR("Not freezing the PerimeterDb: the perfect hash dropped %lli states\n", index->getNumDropped());
+    delete index;
+    return false;
+  }
+  frozen = index;
+
+#ifdef USE_RUNTIME_TABLE_SIZE
+  perimeterDb.release();
+#else
+  delete[] perimeterDb;
+  perimeterDb = NULL;
+#endif
+  return true;
+}
+#endif
+
+inline PerimeterDbEntry * PerimeterDb::getState( const size_t & index )
 {
   PerimeterDbEntry & entry = perimeterDb[index];
   if( entry.cost != MAX_COST )
@@ -240,7 +648,102 @@ inline PerimeterDbEntry * PerimeterDb::getState( const unsigned & index )
 }
 
 
-inline bool PerimeterDb::pruneState( const State & state, const Hash & hash, const int cost, const int iteration )
+inline bool PerimeterDb::pruneState( const State & state, const Hash & hash, const int cost, const int iteration, const Operator & toGoalOp )
+{
+#ifdef USE_PARALLEL_PERIMETER
+  volatile int & lock = locks[calculateIndex(hash) & (PERIMETER_LOCK_STRIPES-1)];
+  while( __sync_lock_test_and_set(&lock, 1) )
+  {
+    while( lock ) {}
+  }
+  const bool pruned = updateState( state, hash, cost, iteration, toGoalOp );
+  __sync_lock_release(&lock);
+  return pruned;
+#else
+  return updateState( state, hash, cost, iteration, toGoalOp );
+#endif
+}
+
+#ifdef USE_PERIMETER_ROBIN_HOOD
+// Entries are never removed, so a probe can stop at the first slot
+// whose entry is closer to its home than the state would be.
+inline PerimeterDbEntry * PerimeterDb::findEntry( const State & state, const Hash & hash ) const
+{
+  unsigned int index = calculateIndex(hash);
+  for( int probe=0; probe<=PERIMETER_MAX_PROBE; probe++ )
+  {
+    PerimeterDbEntry & entry = perimeterDb[index];
+    if( entry.cost == MAX_COST || entry.probe < probe )
+    {
+      return NULL;
+    }
+    if( entry.state == state )
+    {
+      return &entry;
+    }
+    index = nextIndex(index);
+  }
+  return NULL;
+}
+
+inline void PerimeterDb::insertEntry( unsigned int index, PerimeterDbEntry entry )
+{
+  while( true )
+  {
+    PerimeterDbEntry & slot = perimeterDb[index];
+    if( slot.cost == MAX_COST )
+    {
+      slot = entry;
+      return;
+    }
+    if( slot.probe < entry.probe )
+    {	// Robin Hood: the entry further from home takes the slot
+      std::swap(slot, entry);
+    }
+    index = nextIndex(index);
+    entry.probe++;
+    if( entry.probe > PERIMETER_MAX_PROBE )
+    {
+      numDropped++;
+      return;
+    }
+  }
+}
+
+inline bool PerimeterDb::updateState( const State & state, const Hash & hash, const int cost, const int iteration, const Operator & toGoalOp )
+{
+  unsigned int index = calculateIndex(hash);
+  for( int probe=0; probe<=PERIMETER_MAX_PROBE; probe++ )
+  {
+    PerimeterDbEntry & entry = perimeterDb[index];
+    if( entry.cost != MAX_COST && entry.state == state )
+    { // found the node
+      return !entry.updateEntry( cost, iteration, toGoalOp );
+    }
+    if( entry.cost == MAX_COST || entry.probe < probe )
+    { // Not in the table.  Add it here.
+      PerimeterDbEntry newEntry;
+      newEntry.state = state;
+      newEntry.cost = cost;
+#ifdef USE_LAZY_PERIMETER
+      newEntry.iteration = iteration;
+#endif
+#ifdef USE_PERIMETER_SEARCH
+      newEntry.toGoalOp = toGoalOp;
+#endif
+      newEntry.probe = probe;
+      insertEntry( index, newEntry );
+      return false;
+    }
+    index = nextIndex(index);
+  }
+
+  // Every slot within reach holds a state closer to its home
+  numDropped++;
+  return false;
+}
+#else
+inline bool PerimeterDb::updateState( const State & state, const Hash & hash, const int cost, const int iteration, const Operator & toGoalOp )
 {
   // Calculate index and lookup entry
   unsigned int index = calculateIndex(hash);
@@ -252,7 +755,7 @@ inline bool PerimeterDb::pruneState( const State & state, const Hash & hash, con
 
   if( entry.state == state )
   { // found the node
-    if( entry.updateEntry( cost, iteration ) )
+    if( entry.updateEntry( cost, iteration, toGoalOp ) )
     {	// Needs updating
       return false;
     }
@@ -270,13 +773,16 @@ inline bool PerimeterDb::pruneState( const State & state, const Hash & hash, con
 #ifdef USE_LAZY_PERIMETER
     entry.iteration = iteration;
 #endif
+#ifdef USE_PERIMETER_SEARCH
+    entry.toGoalOp = toGoalOp;
+#endif
 #ifdef USE_PERIMETER_STATE_PRIORITIZATION
     entry.priority = priority;
 #endif
     return false;
   }
 #ifdef USE_PERIMETER_STATE_PRIORITIZATION
-  else if ( priority > entry.priority )
+  else if ( entry.losesTo(state, priority) )
   {	// higher priority node-- just replace the entry
 /*    LOG("replacing node: state=");
     entry.state.print();
@@ -289,6 +795,9 @@ inline bool PerimeterDb::pruneState( const State & state, const Hash & hash, con
     entry.cost = cost;
 #ifdef USE_LAZY_PERIMETER
     entry.iteration = iteration;
+#endif
+#ifdef USE_PERIMETER_SEARCH
+    entry.toGoalOp = toGoalOp;
 #endif
     entry.priority = priority;
   }
@@ -297,10 +806,15 @@ inline bool PerimeterDb::pruneState( const State & state, const Hash & hash, con
   // entry occupied by another state-- the state isn't actually updated, but we say it is because it must be expanded.
   return false;
 }
+#endif
 
 inline unsigned int PerimeterDb::calculateIndex( const Hash & hash ) const
 {
+#ifdef USE_RUNTIME_TABLE_SIZE
+  return hash.value & indexMask;
+#else
   return hash.value%PERIMETER_DB_SIZE;
+#endif
 }
 
 #endif
@@ -15,8 +15,42 @@
 #include "domain.h"
 #include "searchState.h"
 #include "transTable.h"
+#include "sharedTransTable.h"
 #include "perimeterDB.h"
+#include "heuristicStore.h"
+#include "heuristicCache.h"
+#include "searchResult.h"
 #include "common.h"
+#include <vector>
+#include <pthread.h>
+
+// The table entries of a node, looked up once when the node is visited
+// and used for its heuristic, pruning and BPMX updates.
+struct NodeVisit
+{
+#ifdef USE_TRANS_TABLE
+  TransTableHandle  ttHandle;			// not used with a shared trans table
+#endif
+#ifdef USE_PERIMETER_SEARCH
+  const PerimeterDbEntry * perimeterEntry;	// NULL if the state isn't in the PerimeterDb
+#endif
+#ifdef USE_HEURISTIC_CACHE
+  unsigned long long signature;		// getSignature(state), the key of the HeuristicCache
+#endif
+};
+
+// One level of an explicit (non-recursive) depth first search stack
+struct DfsFrame
+{
+  OpList        opList;					// successors of the node on this level
+  int           next;						// index of the next operator in opList to search
+  int           heuristic;			// heuristic of the node (may be raised by BPMX)
+  NodeStatus    childrenStatus;
+  NodeVisit     visit;
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+  long long     startCount;			// generationCount when the node was expanded
+#endif
+};
 
 // This class is currently only intended to fill the PerimeterDB.
 // Might be extended later for more general purpose.
@@ -27,6 +61,19 @@ public:
   //SearchState m_goal;
   //SearchState m_start;
   PerimeterDb & perimeterDb;
+#ifdef USE_PARALLEL_PERIMETER
+  // A node at PERIMETER_SPLIT_DEPTH.  Its subtree is searched by one of the threads.
+  struct FrontierNode
+  {
+    SearchState state;
+    Operator    toGoalOp;
+  };
+  // The current iteration, shared by the threads
+  std::vector<FrontierNode> frontier;
+  volatile int nextFrontierNode;
+  int costLimit;
+  int iteration;
+#endif
 
 public:
   DFS(PerimeterDb & _perimeterDb);
@@ -38,13 +85,25 @@ public:
 
 private:
   // Used to create perimeter DB
-  void dfsRecursive( SearchState & state, const int & costLimit, const int & iteration );
+  // toGoalOp is the operator that leads from state back to its parent, towards the goal
+  void dfsRecursive( SearchState & state, const int & costLimit, const int & iteration, const Operator & toGoalOp );
   // returns true if the state should be pruned off the search tree
-  bool prune( const SearchState & state, const int & costLimit, const int & iteration ) ;
+  bool prune( const SearchState & state, const int & costLimit, const int & iteration, const Operator & toGoalOp ) ;
+#ifdef USE_PARALLEL_PERIMETER
+  // Searches one iteration with NUM_THREADS threads
+  void parallelIteration( const SearchState & goal, const int & costLimit, const int & iteration );
+  // Same as dfsRecursive, but stops at PERIMETER_SPLIT_DEPTH and adds the nodes there to the frontier
+  void splitRecursive( SearchState & state, const int & costLimit, const int & iteration, const Operator & toGoalOp, const int & depth );
+  static void * workerMain( void * arg );
+  void runWorker();
+#endif
 };
 
 class IDA
 {
+#ifdef USE_PARALLEL_IDA
+  friend class ParallelIDA;
+#endif
 public:
   long long generationCount;
   SearchState m_goal;
@@ -53,36 +112,104 @@ public:
 #ifdef USE_TRANS_TABLE
   TransTable transTable;
 #endif
+#ifdef USE_SHARED_TRANS_TABLE
+  // Set by ParallelIDA when its workers share a table.  Used instead of transTable.
+  SharedTransTable * sharedTransTable;
+  TransTableStats sharedTransTableStats;
+#endif
 #ifdef USE_PERIMETER_DB
-  PerimeterDb & perimeterDb;
+  // Only read from during the search, so it can be shared between threads.
+  const PerimeterDb & perimeterDb;
+#endif
+#ifdef USE_HEURISTIC_STORE
+  // Heuristic values learnt on earlier instances.  Not owned, NULL if not set.
+  HeuristicStore * heuristicStore;
+#endif
+#ifdef USE_HEURISTIC_CACHE
+  // Kept from one search to the next, while the goal is the same
+  HeuristicCache heuristicCache;
+#endif
+#ifdef USE_ITERATIVE_IDA
+  // The path of idaIterative. frames[d] belongs to the node at depth d.
+  DfsFrame frames[MAX_COST+1];
+#endif
+#ifdef USE_PARALLEL_IDA
+  // Set by another thread to stop the search (eg. a solution was found elsewhere)
+  const volatile bool * abortSearch;
+#endif
+
+  // Thresholds
+  int numIterations;
+  int solutionCost;
+  std::vector<Operator> path;	// built backwards while unwinding from the goal
+  SearchResult result;
+  int minOverflow;			// smallest f-value over the cost limit on this iteration
+#ifdef USE_IDA_CR
+  long long overflowHistogram[MAX_COST+1];	// number of nodes cut off, by f-value
 #endif
 
 public:
 #ifdef USE_PERIMETER_DB
-  IDA(PerimeterDb & _perimeterDb) : perimeterDb(_perimeterDb) {}
+  IDA(const PerimeterDb & _perimeterDb) : perimeterDb(_perimeterDb) { _init(); }
 #else
-  IDA() {}
+  IDA() { _init(); }
 #endif
   ~IDA() {}
 
   // Main search function
   int search(const SearchState & start, const SearchState & goal);
   long long getNodesGenerated() { return generationCount; }
+  int getIterations() const { return numIterations; }
+  // The outcome of the last search, including the path from the start to the goal
+  const SearchResult & getResult() const { return result; }
+  const std::vector<Operator> & getPath() const { return result.path; }
+#ifdef USE_HEURISTIC_STORE
+  void setHeuristicStore(HeuristicStore * store) { heuristicStore = store; }
+#endif
 
 private:
+  void _init();
+
+  // Keep track of the f-values that went over the cost limit,
+  // and pick the next cost limit from them.
+  void resetOverflow();
+  void recordOverflow(const int & f);
+  void mergeOverflow(const IDA & ida);
+  int nextCostLimit(const long long & lastIterationNodes) const;
+
   // prune the node if necessary, and update tables if necessary.
   // return 0 if
   // 1) not over the depth bound
   // 2) not in transposition table and already visited with smaller (or equal) g-value on this iteration.
   PruneStatus prune( const SearchState & state, const int & costLimit, const int & heuristic ) ;//const;
+  PruneStatus prune( const SearchState & state, const int & costLimit, const int & heuristic, NodeVisit & visit );
+
+#ifdef USE_PERIMETER_SEARCH
+  // returns true if the state is in the PerimeterDb and the goal can be reached within costLimit through it.
+  // The stored path from the state to the goal is then put in path.
+  bool reachedPerimeter( const SearchState & state, const int & costLimit, const NodeVisit & visit );
+#endif
 
   int getHeuristic(const SearchState & state) const;
-  void checkHeuristic(const SearchState & state, const int & heur);
+  // Looks the node up in the trans table, for the functions below
+  void startVisit(const SearchState & state, NodeVisit & visit);
+  // The heuristic of a visited node, raised by BPMX with the heuristic of its parent, which is raised in turn.
+  // The PerimeterDb and the HeuristicStore are only probed if the node isn't already cut off.
+  int getHeuristic(const SearchState & state, NodeVisit & visit, const int & costLimit, int & parentHeuristic);
+  void checkHeuristic(const SearchState & state, const int & heur, NodeVisit & visit);
+  // Prefetches the table entries of all the children
+  void prefetchChildren(const SearchState & state, const OpList & opList) const;
+  // Tells the trans table how many nodes were generated below an expanded state
+  void recordSubtreeSize(const SearchState & state, const long long & subtreeSize);
 
   // returns 0 if found a solution
   // returns 1 if all children (or children's children) are in the TT
   // returns 2 if a child (or child's child) is a leaf node.
   NodeStatus idaRecursive( SearchState & state, const int & costLimit, int & prevHeuristic );
+#ifdef USE_ITERATIVE_IDA
+  // Same as idaRecursive, but loops over the frames instead of recursing.
+  NodeStatus idaIterative( SearchState & state, const int & costLimit, int & prevHeuristic );
+#endif
 
   // lookahead past the frontier in the hopes that we can propogate a high heuristic backwards
   NodeStatus lookaheadRecursive( SearchState & state, const int & costLimit, int & prevHeuristic );
@@ -10,11 +10,29 @@
 **/
 
 #include <time.h>
+#include <algorithm>
 
 ////////////////////////////////
 // IDA star search /////////////
 ////////////////////////////////
 
+inline void IDA::_init()
+{
+  generationCount = 0;
+  numIterations = 0;
+  solutionCost = -1;
+  resetOverflow();
+#ifdef USE_PARALLEL_IDA
+  abortSearch = NULL;
+#endif
+#ifdef USE_SHARED_TRANS_TABLE
+  sharedTransTable = NULL;
+#endif
+#ifdef USE_HEURISTIC_STORE
+  heuristicStore = NULL;
+#endif
+}
+
 inline int IDA::getHeuristic(const SearchState & state) const
 {
   int returnVal = 0;
@@ -33,37 +51,207 @@ inline int IDA::getHeuristic(const SearchState & state) const
   returnVal = std::max( returnVal, perimeterHeuristicVal );
 #endif
 #if defined USE_TRANS_TABLE && defined USE_TRANS_TABLE_HEUR_CACHING
+#ifdef USE_SHARED_TRANS_TABLE
+  const int cachedHeuristicVal = sharedTransTable ?
+    sharedTransTable->getCachedHeuristic(state.state, state.hash) :
+    this->transTable.getCachedHeuristic(state.state, state.hash);
+#else
   const int cachedHeuristicVal = this->transTable.getCachedHeuristic(state.state, state.hash);
+#endif
   returnVal = std::max(returnVal, cachedHeuristicVal);
 #endif
+#ifdef USE_HEURISTIC_STORE
+  if( heuristicStore )
+  {
+    returnVal = std::max(returnVal, heuristicStore->getHeuristic(state.state, state.hash));
+  }
+#endif
 
   return returnVal;
 }
 
-inline void IDA::checkHeuristic(const SearchState & state, const int & heur)
+inline void IDA::startVisit(const SearchState & state, NodeVisit & visit)
+{
+#ifdef USE_TRANS_TABLE
+  visit.ttHandle = TransTableHandle(state.state, state.hash);
+#ifdef USE_SHARED_TRANS_TABLE
+  if( !sharedTransTable )
+#endif
+  {
+    transTable.lookup(visit.ttHandle);
+  }
+#endif
+#ifdef USE_PERIMETER_SEARCH
+  visit.perimeterEntry = NULL;
+#endif
+#ifdef USE_HEURISTIC_CACHE
+  visit.signature = getSignature(state.state);
+#endif
+}
+
+inline int IDA::getHeuristic(const SearchState & state, NodeVisit & visit, const int & costLimit, int & parentHeuristic)
+{
+  int heuristic = 0;
+#ifdef USE_HEURISTIC
+  heuristic = state.incHeuristic.value;
+#endif
+#if defined USE_TRANS_TABLE && defined USE_TRANS_TABLE_HEUR_CACHING
+#ifdef USE_SHARED_TRANS_TABLE
+  const int cachedHeuristicVal = sharedTransTable ?
+    sharedTransTable->getCachedHeuristic(state.state, state.hash) :
+    this->transTable.getCachedHeuristic(visit.ttHandle);
+#else
+  const int cachedHeuristicVal = this->transTable.getCachedHeuristic(visit.ttHandle);
+#endif
+  heuristic = std::max(heuristic, cachedHeuristicVal);
+#endif
+#ifdef USE_HEURISTIC_CACHE
+  const int cacheHeuristicVal = heuristicCache.getHeuristic(visit.signature);
+  if( cacheHeuristicVal > heuristic )
+  {
+    heuristicCache.stats.raises++;
+    heuristic = cacheHeuristicVal;
+  }
+#endif
+#ifdef USE_BPMX
+  heuristic = std::max(parentHeuristic-1, heuristic);
+#endif
+
+  // The other tables cost a cache miss each.  Skip them if the node is cut off anyway.
+  if( state.cost + heuristic <= costLimit )
+  {
+#if defined USE_PERIMETER_DB && defined USE_PERIMETER_SEARCH
+    visit.perimeterEntry = perimeterDb.lookup(state.state, state.hash);
+    if( visit.perimeterEntry )
+    {
+      heuristic = std::max(heuristic, visit.perimeterEntry->cost);
+    }
+#elif defined USE_PERIMETER_DB
+    heuristic = std::max(heuristic, perimeterDb.getHeuristic(state.state, state.hash));
+#endif
+#ifdef USE_HEURISTIC_STORE
+    if( heuristicStore )
+    {
+      heuristic = std::max(heuristic, heuristicStore->getHeuristic(state.state, state.hash));
+    }
+#endif
+  }
+
+#ifdef USE_BPMX
+  parentHeuristic = std::max(parentHeuristic, heuristic-1);
+#endif
+  return heuristic;
+}
+
+inline void IDA::checkHeuristic(const SearchState & state, const int & heur, NodeVisit & visit)
 {
+#ifdef USE_HEURISTIC_STORE
+#ifdef USE_HEURISTIC
+  // Only the values that can't be computed again
+  if( heuristicStore && heur > state.incHeuristic.value )
+#else
+  if( heuristicStore )
+#endif
+  {
+    heuristicStore->update(state.state, state.hash, heur);
+  }
+#endif
+#ifdef USE_HEURISTIC_CACHE
+#ifdef USE_HEURISTIC
+  // Only the values that can't be computed again
+  if( heur > state.incHeuristic.value )
+#endif
+  {
+    heuristicCache.update(visit.signature, heur);
+  }
+#endif
 #if defined USE_TRANS_TABLE && defined USE_TRANS_TABLE_HEUR_CACHING
-  //const int transTableCachedHeurVal = this->transTable.getCachedHeuristic(state.state, state.hash);
-  this->transTable.updateCachedHeuristic(state.state, state.hash, heur );
-  //transTableCachedHeurVal = std::max( heur, transTableCachedHeurVal, heur );
+#ifdef USE_SHARED_TRANS_TABLE
+  if( sharedTransTable )
+  {
+    sharedTransTable->updateCachedHeuristic(state.state, state.hash, heur );
+    return;
+  }
+#endif
+  this->transTable.updateCachedHeuristic(visit.ttHandle, heur );
 #endif
 }
 
+inline void IDA::prefetchChildren(const SearchState & state, const OpList & opList) const
+{
+#if defined USE_PREFETCH && defined USE_HASH
+  for( int i=0; i<opList.length; i++ )
+  {
+    const Hash hash = state.childHash( opList.ops[i] );
+#ifdef USE_PERIMETER_DB
+    perimeterDb.prefetch(hash);
+#endif
+#ifdef USE_SHARED_TRANS_TABLE
+    if( sharedTransTable )
+    {
+      sharedTransTable->prefetch(hash);
+      continue;
+    }
+#endif
+#ifdef USE_TRANS_TABLE
+    transTable.prefetch(hash);
+#endif
+  }
+#endif
+}
+
+inline void IDA::recordSubtreeSize(const SearchState & state, const long long & subtreeSize)
+{
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+#ifdef USE_SHARED_TRANS_TABLE
+  if( sharedTransTable )
+  {
+    return;
+  }
+#endif
+  this->transTable.updateSubtreeSize(state.state, state.hash, subtreeSize);
+#endif
+}
+
+// For nodes that weren't looked up with startVisit
 inline PruneStatus IDA::prune(
   const SearchState & state,
   const int & costLimit,
   const int & heur
   ) //const
+{
+  NodeVisit visit;
+  startVisit(state, visit);
+  return prune(state, costLimit, heur, visit);
+}
+
+inline PruneStatus IDA::prune(
+  const SearchState & state,
+  const int & costLimit,
+  const int & heur,
+  NodeVisit & visit
+  )
 {
   //const int heur = 0;
 
   if( state.cost + heur > costLimit )
   {
+    recordOverflow(state.cost + heur);
     return NODE_PRUNED_BY_COST;
   }
 
+#ifdef USE_SHARED_TRANS_TABLE
+  if( sharedTransTable )
+  {
+    if( sharedTransTable->pruneState(state.state, state.hash, heur, state.cost, costLimit, sharedTransTableStats) )
+    {
+      return NODE_PRUNED_BY_TT;
+    }
+    return NODE_NEEDS_EXPANSION;
+  }
+#endif
 #ifdef USE_TRANS_TABLE
-  if( transTable.pruneState(state.state, state.hash, heur, state.cost, costLimit) )
+  if( transTable.pruneState(visit.ttHandle, heur, state.cost, costLimit) )
   {
     return NODE_PRUNED_BY_TT;
   }
@@ -87,6 +275,103 @@ inline PruneStatus IDA::prune(
   return NODE_NEEDS_EXPANSION;
 }
 
+inline void IDA::resetOverflow()
+{
+  minOverflow = MAX_COST;
+#ifdef USE_IDA_CR
+  for( int i=0; i<=MAX_COST; i++ )
+  {
+    overflowHistogram[i] = 0;
+  }
+#endif
+}
+
+inline void IDA::recordOverflow(const int & f)
+{
+  minOverflow = std::min(minOverflow, f);
+#ifdef USE_IDA_CR
+  overflowHistogram[std::min(f, MAX_COST)]++;
+#endif
+}
+
+// Used to combine the overflow of parallel workers
+inline void IDA::mergeOverflow(const IDA & ida)
+{
+  minOverflow = std::min(minOverflow, ida.minOverflow);
+#ifdef USE_IDA_CR
+  for( int i=0; i<=MAX_COST; i++ )
+  {
+    overflowHistogram[i] += ida.overflowHistogram[i];
+  }
+#endif
+}
+
+// returns MAX_COST if nothing went over the cost limit
+inline int IDA::nextCostLimit(const long long & lastIterationNodes) const
+{
+#ifdef USE_IDA_CR
+  // Smallest limit that lets at least lastIterationNodes of the cut off nodes through
+  long long numNodes = 0;
+  int costLimit = minOverflow;
+  for( int f=minOverflow; f<MAX_COST; f++ )
+  {
+    if( overflowHistogram[f] == 0 )
+    {
+      continue;
+    }
+    costLimit = f;
+    numNodes += overflowHistogram[f];
+    if( numNodes >= lastIterationNodes )
+    {
+      break;
+    }
+  }
+  return costLimit;
+#else
+  return minOverflow;
+#endif
+}
+
+#ifdef USE_PERIMETER_SEARCH
+// The PerimeterDb entry of the state was looked up by getHeuristic
+inline bool IDA::reachedPerimeter( const SearchState & state, const int & costLimit, const NodeVisit & visit )
+{
+  const PerimeterDbEntry * entry = visit.perimeterEntry;
+  if( !entry || state.cost + entry->cost > costLimit )
+  {
+    return false;
+  }
+  const int perimeterCost = entry->cost;
+
+  // Follow the operators recorded by DFS::dfsRecursive.
+  // Every step must lead to an entry that is closer to the goal by exactly the step cost,
+  // otherwise the next state was lost to a collision and the path can't be rebuilt.
+  std::vector<Operator> goalPath;
+  SearchState current = state;
+  while( entry->cost > 0 )
+  {
+    const int oldCost = current.cost;
+    const int oldPerimeterCost = entry->cost;
+    const Operator op = entry->toGoalOp;
+    current.apply( op );
+    goalPath.push_back( op );
+    entry = perimeterDb.lookup(current.state, current.hash);
+    if( !entry || entry->cost != oldPerimeterCost - (current.cost - oldCost) )
+    {
+      return false;
+    }
+  }
+  if( !(current == m_goal) )
+  {
+    return false;
+  }
+
+  solutionCost = state.cost + perimeterCost;
+  path.assign( goalPath.rbegin(), goalPath.rend() );
+  return true;
+}
+#endif
+
 void indent(LogLevel level, int num)
 {
   for(int i=0; i<num; ++i)
@@ -95,16 +380,20 @@ void indent(LogLevel level, int num)
 
 NodeStatus IDA::idaRecursive( SearchState & state, const int & costLimit, int & prevHeuristic )
 {
+#ifdef USE_PARALLEL_IDA
+  if( abortSearch && *abortSearch )
+  {	// another thread finished the iteration.  Unwind quickly.
+    return SEARCH_SOME_CHILDREN_LEAF;
+  }
+#endif
   generationCount++;
 
   // find heuristic
-  int heuristic = getHeuristic(state);
-#ifdef USE_BPMX
-  heuristic = std::max(prevHeuristic-1,heuristic);
-  prevHeuristic = std::max(prevHeuristic, heuristic-1);
-#endif
-#if defined USE_TRANS_TABLE && defined USE_TRANS_TABLE_HEUR_CACHING
-  checkHeuristic(state, heuristic);
+  NodeVisit visit;
+  startVisit(state, visit);
+  int heuristic = getHeuristic(state, visit, costLimit, prevHeuristic);
+#ifdef USE_HEURISTIC_UPDATES
+  checkHeuristic(state, heuristic, visit);
 #endif
 
   // Debugging
@@ -116,7 +405,7 @@ NodeStatus IDA::idaRecursive( SearchState & state, const int & costLimit, int &
   LOG_DEBUG(" costLimit=%i \n",costLimit);
 
   // Only continue if node needs expansion.
-  PruneStatus pruneStatus = prune(state,costLimit,heuristic);
+  PruneStatus pruneStatus = prune(state,costLimit,heuristic,visit);
   if( pruneStatus == NODE_PRUNED_BY_TT )
   {
     return SEARCH_NODE_IN_TT;
@@ -138,14 +427,21 @@ NodeStatus IDA::idaRecursive( SearchState & state, const int & costLimit, int &
   if( state == m_goal )
   {
     //LOG(" |-- > solution! \n");
-    LOG("\n");
-    state.print(NORMAL);
-    LOG(" \n" );
+    solutionCost = state.cost;
+    path.clear();
     return SEARCH_FOUND_SOLUTION;	// Found the solution
   }
+#ifdef USE_PERIMETER_SEARCH
+  if( reachedPerimeter(state, costLimit, visit) )
+  {
+    return SEARCH_FOUND_SOLUTION;
+  }
+#endif
 
   NodeStatus childrenStatus = SEARCH_ALL_CHILDREN_IN_TT;
   const OpList opList = state.findSuccessorOperators();
+  const long long startCount = generationCount;
+  prefetchChildren(state, opList);
 
   // Debug
   indent(DEBUG,state.cost);
@@ -163,31 +459,181 @@ NodeStatus IDA::idaRecursive( SearchState & state, const int & costLimit, int &
 
     if( status == SEARCH_FOUND_SOLUTION )
     {
-      state.print(NORMAL);
-      LOG(" op=%i\n", opList.ops[i] );
+      path.push_back( opList.ops[i] );
       return SEARCH_FOUND_SOLUTION;
     } else if ( status == SEARCH_SOME_CHILDREN_LEAF )
     {
       childrenStatus = SEARCH_SOME_CHILDREN_LEAF;
     }
 
-#if defined USE_TRANS_TABLE && defined USE_TRANS_TABLE_HEUR_CACHING
-    checkHeuristic(state, heuristic);
+#ifdef USE_HEURISTIC_UPDATES
+    checkHeuristic(state, heuristic, visit);
 #endif
 #ifdef USE_BPMX
     if( state.cost + heuristic > costLimit )
     {	// heuristic propogated backwards and caused a parental cutoff
       //LOG(".");
+      recordOverflow(state.cost + heuristic);
       prevHeuristic = std::max(prevHeuristic, heuristic-1);
+      recordSubtreeSize(state, generationCount - startCount);
       return SEARCH_SOME_CHILDREN_LEAF;
     }
 #endif
 
   }
 
+  recordSubtreeSize(state, generationCount - startCount);
   return childrenStatus;
 }
 
+#ifdef USE_ITERATIVE_IDA
+// The node and BPMX handling is the same as in idaRecursive.
+// frames[d].opList.ops[frames[d].next-1] is the operator that leads
+// from the node at depth d to the node at depth d+1.
+NodeStatus IDA::idaIterative( SearchState & state, const int & costLimit, int & prevHeuristic )
+{
+  NodeStatus status;
+  int depth = 0;
+
+  while( true )
+  {
+#ifdef USE_PARALLEL_IDA
+    if( abortSearch && *abortSearch )
+    {	// another thread finished the iteration.  Unwind quickly.
+      for( ; depth>0; depth-- )
+      {
+        state.unapply( frames[depth-1].opList.ops[frames[depth-1].next-1] );
+      }
+      return SEARCH_SOME_CHILDREN_LEAF;
+    }
+#endif
+    generationCount++;
+
+    // find heuristic
+    int & parentHeuristic = (depth == 0) ? prevHeuristic : frames[depth-1].heuristic;
+    NodeVisit & visit = frames[depth].visit;
+    startVisit(state, visit);
+    int heuristic = getHeuristic(state, visit, costLimit, parentHeuristic);
+#ifdef USE_HEURISTIC_UPDATES
+    checkHeuristic(state, heuristic, visit);
+#endif
+
+    // Debugging
+    indent(DEBUG,state.cost);
+    state.print(DEBUG);
+#ifdef USE_HEURISTIC
+    LOG_DEBUG(" heur=%i",heuristic);
+#endif
+    LOG_DEBUG(" costLimit=%i \n",costLimit);
+
+    // Only continue if node needs expansion.
+    PruneStatus pruneStatus = prune(state,costLimit,heuristic,visit);
+    if( pruneStatus == NODE_PRUNED_BY_TT )
+    {
+      status = SEARCH_NODE_IN_TT;
+    }
+    else if( pruneStatus == NODE_PRUNED_BY_COST )
+    {
+#ifdef USE_LOOKAHEAD
+      lookaheadRecursive(state,costLimit+3,heuristic);
+#endif
+      status = SEARCH_SOME_CHILDREN_LEAF;
+    }
+#ifdef USE_PERIMETER_SEARCH
+    else if( state == m_goal || reachedPerimeter(state, costLimit, visit) )
+#else
+    else if( state == m_goal )
+#endif
+    {
+      if( state == m_goal )
+      {
+        solutionCost = state.cost;
+        path.clear();
+      }
+      // Unwind, recording the path the same way idaRecursive does
+      for( ; depth>0; depth-- )
+      {
+        const DfsFrame & frame = frames[depth-1];
+        state.unapply( frame.opList.ops[frame.next-1] );
+        path.push_back( frame.opList.ops[frame.next-1] );
+      }
+      return SEARCH_FOUND_SOLUTION;
+    }
+    else
+    {
+      // Expand
+      DfsFrame & frame = frames[depth];
+      frame.opList = state.findSuccessorOperators();
+      frame.next = 0;
+      prefetchChildren(state, frame.opList);
+      frame.heuristic = heuristic;
+      frame.childrenStatus = SEARCH_ALL_CHILDREN_IN_TT;
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+      frame.startCount = generationCount;
+#endif
+
+      // Debug
+      indent(DEBUG,state.cost);
+      frame.opList.print(DEBUG);
+      LOG_DEBUG("\n");
+
+      if( frame.next < frame.opList.length )
+      {
+        state.apply( frame.opList.ops[frame.next++] );
+        depth++;
+        continue;
+      }
+      status = frame.childrenStatus;
+      recordSubtreeSize(state, 0);
+    }
+
+    // Return the status to the parents, until one of them has another child to search.
+    while( true )
+    {
+      if( depth == 0 )
+      {
+        return status;
+      }
+      depth--;
+      DfsFrame & frame = frames[depth];
+      state.unapply( frame.opList.ops[frame.next-1] );
+
+      if( status == SEARCH_SOME_CHILDREN_LEAF )
+      {
+        frame.childrenStatus = SEARCH_SOME_CHILDREN_LEAF;
+      }
+#ifdef USE_HEURISTIC_UPDATES
+      checkHeuristic(state, frame.heuristic, frame.visit);
+#endif
+#ifdef USE_BPMX
+      if( state.cost + frame.heuristic > costLimit )
+      {	// heuristic propogated backwards and caused a parental cutoff
+        recordOverflow(state.cost + frame.heuristic);
+        int & grandparentHeuristic = (depth == 0) ? prevHeuristic : frames[depth-1].heuristic;
+        grandparentHeuristic = std::max(grandparentHeuristic, frame.heuristic-1);
+        status = SEARCH_SOME_CHILDREN_LEAF;
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+        recordSubtreeSize(state, generationCount - frame.startCount);
+#endif
+        continue;
+      }
+#endif
+
+      if( frame.next < frame.opList.length )
+      {
+        state.apply( frame.opList.ops[frame.next++] );
+        depth++;
+        break;
+      }
+      status = frame.childrenStatus;
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+      recordSubtreeSize(state, generationCount - frame.startCount);
+#endif
+    }
+  }
+}
+#endif
+
 #ifdef USE_LOOKAHEAD
 NodeStatus IDA::lookaheadRecursive( SearchState & state, const int & costLimit, int & prevHeuristic )
 {
@@ -244,8 +690,7 @@ NodeStatus IDA::lookaheadRecursive( SearchState & state, const int & costLimit,
     /*
     if( status == SEARCH_FOUND_SOLUTION )
     {
-      state.print(NORMAL);
-      LOG(" op=%i\n", opList.ops[i] );
+      path.push_back( opList.ops[i] );
       return SEARCH_FOUND_SOLUTION;
     } else if ( status == SEARCH_SOME_CHILDREN_LEAF )
     {
@@ -276,9 +721,18 @@ inline int IDA::search(const SearchState & start, const SearchState & goal)
 {
   int depth = 0;
   generationCount = 0;
+  numIterations = 0;
+  solutionCost = -1;
+  path.clear();
+  result.clear();
   clock_t totalClockTicks = 0;
-  int oldNodeCount = 0;
-  double time;
+#ifdef USE_HEURISTIC_CACHE
+  if( !(goal == m_goal) )
+  {	// The cached values are distances to the old goal
+    heuristicCache.clear();
+  }
+  heuristicCache.stats.reset();
+#endif
   m_goal = goal;
   //m_goal.print(NORMAL);
   //LOG("\n");
@@ -288,16 +742,20 @@ inline int IDA::search(const SearchState & start, const SearchState & goal)
   transTable.reset();
 #endif
 
+  // No solution can be cheaper than the heuristic of the start state
+  depth = getHeuristic(start);
+  long long lastNodeCount = 0;
+
   SearchState state;
   while( status != SEARCH_FOUND_SOLUTION && depth < MAX_COST )
   {
     state = start;
-    depth++;
-    oldNodeCount = 0;
+    numIterations++;
+    resetOverflow();
 #ifdef USE_TRANS_TABLE
 #ifndef USE_LAZY_TRANS_TABLE
 //#ifndef USE_TT_SCAN_EXPANSION
-    transTable.resetTT();
+    transTable.clear();
 //#endif
 #endif
 #endif
@@ -305,7 +763,11 @@ inline int IDA::search(const SearchState & start, const SearchState & goal)
 
 #ifndef USE_TT_SCAN_EXPANSION
     int heur = 0;
+#ifdef USE_ITERATIVE_IDA
+    status = idaIterative(state, depth, heur);
+#else
     status = idaRecursive(state, depth, heur);
+#endif
 #else
 /*
     // TODO: clean this up.
@@ -332,25 +794,43 @@ inline int IDA::search(const SearchState & start, const SearchState & goal)
     }
 */
 #endif
-    totalClockTicks += clock() - startClock;
-    time = (double)totalClockTicks/CLOCKS_PER_SEC;
-    LOG("depth=%2i genCnt=%13lld time=%6.2fsec nps=%9.f ",
-      depth, generationCount,
-      time, generationCount/time );
+    const clock_t iterationClockTicks = clock() - startClock;
+    totalClockTicks += iterationClockTicks;
 #ifdef USE_TRANS_TABLE
-    LOG("fill=%.3f", transTable.percentFull() );
-    //LOG("\n");
-    //printTT( transTable );
-    //printTTInfo( transTable );
+    const double ttFill = transTable.percentFull();
+#else
+    const double ttFill = -1.0;
 #endif
-    LOG("\n");
+    result.addIteration( depth, generationCount - lastNodeCount,
+      (double)iterationClockTicks/CLOCKS_PER_SEC, ttFill );
+
+    if( status != SEARCH_FOUND_SOLUTION )
+    {
+      depth = nextCostLimit(generationCount - lastNodeCount);
+      lastNodeCount = generationCount;
+    }
   }
 
+  result.nodesGenerated = generationCount;
+  result.time = (double)totalClockTicks/CLOCKS_PER_SEC;
+#ifdef USE_TRANS_TABLE
+  result.ttStats = transTable.stats;
+#endif
+#ifdef USE_SHARED_TRANS_TABLE
+  if( sharedTransTable )
+  {
+    result.ttStats = sharedTransTableStats;
+  }
+#endif
+
   // If didn't find solution, then we went up to our maximum depth.  May want to increase MAX_DEPTH.
   if( status != SEARCH_FOUND_SOLUTION)
-    depth = -1;
+    return -1;
 
-  return depth;
+  std::reverse( path.begin(), path.end() );
+  result.solutionLength = solutionCost;
+  result.path = path;
+  return solutionCost;
 }
 
 ///////////////////////////////
@@ -366,8 +846,12 @@ inline void DFS::search( const SearchState & goal, const int & depth)
   LOG("Populating PerimeterDb\n");
   for( int d=0; d<depth; ++d )
   {
+#ifdef USE_PARALLEL_PERIMETER
+    parallelIteration( goal, d, d );
+#else
     state = goal;
-    dfsRecursive( state, d, d);
+    dfsRecursive( state, d, d, NO_OP );
+#endif
     LOG("\n");
     printTime(NORMAL);
     LOG("depth=%3.i ", d);
@@ -388,7 +872,7 @@ inline void DFS::search( const SearchState & goal, const int & depth)
   const int iteration = 2;
   for( int it=0; it<iteration; ++it)
   {
-      for( unsigned int i=0; i<PERIMETER_DB_SIZE; ++i)
+      for( size_t i=0; i<perimeterDb.size(); ++i)
       {
         PerimeterDbEntry* entry = perimeterDb.getState(i);
         if( entry )
@@ -400,7 +884,7 @@ inline void DFS::search( const SearchState & goal, const int & depth)
           state.init();
           state.cost = entry->cost;
           // search
-          dfsRecursive( state, state.cost+ERROR*it, depth+it );
+          dfsRecursive( state, state.cost+ERROR*it, depth+it, NO_OP );
         }
       }
       LOG("depth=%3.i ", depth+ERROR*it);
@@ -411,7 +895,7 @@ inline void DFS::search( const SearchState & goal, const int & depth)
 
 }
 
-inline void DFS::dfsRecursive( SearchState & state, const int & costLimit, const int & iteration )
+inline void DFS::dfsRecursive( SearchState & state, const int & costLimit, const int & iteration, const Operator & toGoalOp )
 {
   generationCount++;
   // Debugging
@@ -419,7 +903,7 @@ inline void DFS::dfsRecursive( SearchState & state, const int & costLimit, const
   LOG_DEBUG(" costLimit=%i iteration=%i\n",costLimit,iteration);
 
   // Only continue if node needs expansion.
-  if( prune(state,costLimit, iteration) )
+  if( prune(state,costLimit, iteration, toGoalOp) )
   {
     return;
   }
@@ -437,19 +921,94 @@ inline void DFS::dfsRecursive( SearchState & state, const int & costLimit, const
   for( int i=0; i<opList.length; i++ )
   {
     state.apply( opList.ops[i] );
-    /*NodeStatus status =*/ dfsRecursive( state, costLimit, iteration );
+    /*NodeStatus status =*/ dfsRecursive( state, costLimit, iteration, reverse(opList.ops[i]) );
     state.unapply( opList.ops[i] );
   }
 
   return;// childrenStatus;
 }
 
+#ifdef USE_PARALLEL_PERIMETER
+inline void DFS::parallelIteration( const SearchState & goal, const int & _costLimit, const int & _iteration )
+{
+  costLimit = _costLimit;
+  iteration = _iteration;
+  frontier.clear();
+  nextFrontierNode = 0;
+  SearchState state = goal;
+  splitRecursive( state, costLimit, iteration, NO_OP, 0 );
+
+  pthread_t threads[NUM_THREADS];
+  for( int i=0; i<NUM_THREADS; i++ )
+  {
+    if( pthread_create(&threads[i], NULL, workerMain, this) != 0 )
+    {
+      LOG_ERROR("Could not create perimeter thread %i\n", i);
+      exit(1);
+    }
+  }
+  for( int i=0; i<NUM_THREADS; i++ )
+  {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+inline void DFS::splitRecursive( SearchState & state, const int & costLimit, const int & iteration, const Operator & toGoalOp, const int & depth )
+{
+  if( depth == PERIMETER_SPLIT_DEPTH )
+  {
+    FrontierNode node;
+    node.state = state;
+    node.toGoalOp = toGoalOp;
+    frontier.push_back(node);
+    return;
+  }
+
+  generationCount++;
+  if( prune(state, costLimit, iteration, toGoalOp) )
+  {
+    return;
+  }
+
+  const OpList opList = state.findPredecessorOperators();
+  for( int i=0; i<opList.length; i++ )
+  {
+    state.apply( opList.ops[i] );
+    splitRecursive( state, costLimit, iteration, reverse(opList.ops[i]), depth+1 );
+    state.unapply( opList.ops[i] );
+  }
+}
+
+void * DFS::workerMain( void * arg )
+{
+  ((DFS*)arg)->runWorker();
+  return NULL;
+}
+
+inline void DFS::runWorker()
+{
+  DFS worker(perimeterDb);
+  while( true )
+  {
+    const int i = __sync_fetch_and_add(&nextFrontierNode, 1);
+    if( i >= (int)frontier.size() )
+    {
+      break;
+    }
+    SearchState state = frontier[i].state;
+    worker.dfsRecursive( state, costLimit, iteration, frontier[i].toGoalOp );
+  }
+  __sync_fetch_and_add(&generationCount, worker.generationCount);
+}
+#endif
+
 // return true if pruned
 // return false if needs expansion
 inline bool DFS::prune(
   const SearchState & state,
   const int & costLimit,
-  const int & iteration
+  const int & iteration,
+  const Operator & toGoalOp
   )
 {
   if( state.cost > costLimit )
@@ -459,7 +1018,7 @@ inline bool DFS::prune(
   }
 
 #ifdef USE_PERIMETER_DB
-  if( perimeterDb.pruneState(state.state, state.hash, state.cost, iteration) )
+  if( perimeterDb.pruneState(state.state, state.hash, state.cost, iteration, toGoalOp) )
   {
     //LOG("pruning by PerimeterDb=%i limit=%i iteration=%i\n",state.cost,costLimit,iteration);
     return true;
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifndef SEARCH_RESULT_H
+#define SEARCH_RESULT_H
+
+#include "common.h"
+#include "domain.h"
+#include "transTable.h"
+#include <vector>
+
+// What happened on one iteration of an iterative deepening search
+struct IterationResult
+{
+  int           costLimit;
+  long long     nodesGenerated;	// on this iteration only
+  double        time;						// seconds spent on this iteration
+  double        ttFill;					// fraction of the trans table in use afterwards, -1 without one
+};
+
+// Everything a search reports.
+// The search code only fills this in, the caller decides what to print.
+class SearchResult
+{
+public:
+  int                           solutionLength;	// cost of the solution, -1 if none was found
+  std::vector<Operator>         path;						// operators from the start to the goal
+  std::vector<IterationResult>  iterations;
+  long long                     nodesGenerated;
+  double                        time;						// seconds
+#ifdef USE_TRANS_TABLE
+  TransTableStats               ttStats;
+#endif
+
+public:
+  SearchResult() { clear(); }
+  void clear();
+  void addIteration( const int & costLimit, const long long & nodesGenerated, const double & time, const double & ttFill );
+  int getIterations() const { return (int)iterations.size(); }
+  void print( LogLevel level ) const;
+};
+
+inline void SearchResult::clear()
+{
+  solutionLength = -1;
+  path.clear();
+  iterations.clear();
+  nodesGenerated = 0;
+  time = 0.0;
+#ifdef USE_TRANS_TABLE
+  ttStats.reset();
+#endif
+}
+
+inline void SearchResult::addIteration( const int & costLimit, const long long & nodesGenerated, const double & time, const double & ttFill )
+{
+  IterationResult iteration;
+  iteration.costLimit = costLimit;
+  iteration.nodesGenerated = nodesGenerated;
+  iteration.time = time;
+  iteration.ttFill = ttFill;
+  iterations.push_back(iteration);
+}
+
+// One line per iteration, with the node count and time summed up to that iteration,
+// followed by the path.
+inline void SearchResult::print( LogLevel level ) const
+{
+  long long totalNodes = 0;
+  double totalTime = 0.0;
+  for( unsigned int i=0; i<iterations.size(); i++ )
+  {
+    const IterationResult & iteration = iterations[i];
+    totalNodes += iteration.nodesGenerated;
+    totalTime += iteration.time;
+    _LOG(level, "depth=%2i genCnt=%13lld time=%6.2fsec nps=%9.f ",
+      iteration.costLimit, totalNodes, totalTime, totalNodes/totalTime );
+    if( iteration.ttFill >= 0.0 )
+    {
+      _LOG(level, "fill=%.3f", iteration.ttFill );
+    }
+    _LOG(level, "\n");
+  }
+#ifdef USE_TRANS_TABLE
+  if( ttStats.probes > 0 )
+  {
+    _LOG(level, "ttProbes=%lld ttHitRate=%.3f\n", ttStats.probes, ttStats.hitRate() );
+  }
+#endif
+  if( solutionLength >= 0 )
+  {
+    _LOG(level, "path=[");
+    for( unsigned int i=0; i<path.size(); i++ )
+    {
+      _LOG(level, " %i", path[i]);
+    }
+    _LOG(level, " ] length=%i\n", solutionLength);
+  }
+}
+
+#endif	// SEARCH_RESULT_H
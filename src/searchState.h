@@ -59,6 +59,10 @@ public:
   void unapply( const Operator & op );
   const OpList findSuccessorOperators() const;
   const OpList findPredecessorOperators() const;
+#ifdef USE_HASH
+  // The hash of the state that op leads to, without changing this state
+  Hash childHash( const Operator & op ) const;
+#endif
   void print( LogLevel level ) const;
   // Take numRandOps random operations away from the current state.
   // These operations had better be reversable,
@@ -199,6 +203,16 @@ inline void SearchState::randomize( const int numRandOps )
   }
 }
 
+#ifdef USE_HASH
+inline Hash SearchState::childHash( const Operator & op ) const
+{
+  State child = this->state;
+  Hash hash = this->hash;
+  child.apply(op, NULL, &hash);
+  return hash;
+}
+#endif
+
 inline const OpList SearchState::findSuccessorOperators( ) const
 {
 #ifdef USE_SKIP_TRANS_OP
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_SHARED_TRANS_TABLE
+
+#ifndef SHARED_TRANS_TABLE_H
+#define SHARED_TRANS_TABLE_H
+
+#include "common.h"
+#include "domain.h"
+#include "transTable.h"
+
+// The cost, cost limit, cached heuristic and priority of an entry, packed into 64 bits.
+// costLimit is stored +1, so that a packed value of 0 means an empty entry.
+class SharedTransTableData
+{
+public:
+  int           cost;
+  int           costLimit;
+  int           heuristic;
+  unsigned int  priority;
+
+public:
+  SharedTransTableData() : cost(MAX_COST), costLimit(-1), heuristic(0), priority(0) {}
+  void unpack(const unsigned long long & data);
+  unsigned long long pack() const;
+  bool updateEntry(const int & cost, const int & costLimit);
+};
+
+// Each entry is two 64 bit words, written without a lock.
+// The state is not stored, only its signature xor'ed with the data word.
+// If a reader sees half of a write (or another state's entry), the check
+// no longer matches the signature and the entry is treated as a miss.
+struct SharedTransTableEntry
+{
+  volatile unsigned long long check;	// signature ^ data
+  volatile unsigned long long data;
+};
+
+// Transposition table that many search threads probe and update at the same time.
+// Same interface and replacement policy as TransTable.
+// Lost updates only cost pruning, they never make the search incorrect.
+class SharedTransTable
+{
+private:
+  SharedTransTableEntry * transTable;
+  const unsigned int size;
+
+public:
+  SharedTransTable(const unsigned int _size) : size(_size) { transTable = new SharedTransTableEntry[size]; reset(); }
+  ~SharedTransTable() { delete[] transTable; }
+  void reset();
+
+  // Adds or updates the state in the trans table,
+  // and returns true if the node already exists and should be pruned from the search tree.
+  // returns false if the state must be expanded.
+  // The probe is counted in stats, which belong to the calling thread.
+  bool pruneState( const State & state, const Hash & hash, const int & heur, const int & cost, const int & costLimit, TransTableStats & stats );
+
+  // Returns the cached heuristic value, if the state exists in the table
+  // returns 0 otherwise
+  int getCachedHeuristic( const State & state, const Hash & hash ) const;
+  // Starts loading the entry of the state into the cache
+  void prefetch( const Hash & hash ) const { __builtin_prefetch( &transTable[calculateIndex(hash)] ); }
+  // updates the cached heuristic value if it is large enough
+  void updateCachedHeuristic( const State & state, const Hash & hash, const int & heuristic ) const;
+
+  // Stats
+  void printInfo(LogLevel level) const;
+  double percentFull( ) const;
+
+private:
+  // returns true and fills in data if the entry belongs to the signature
+  bool readEntry( const SharedTransTableEntry & entry, const unsigned long long & signature, SharedTransTableData & data ) const;
+  void writeEntry( SharedTransTableEntry & entry, const unsigned long long & signature, const SharedTransTableData & data ) const;
+  long long numEntries( ) const;
+  unsigned int calculateIndex( const Hash & hash ) const;
+};
+
+#include "sharedTransTable.hpp"
+
+#endif	// SHARED_TRANS_TABLE_H
+#endif	// USE_SHARED_TRANS_TABLE
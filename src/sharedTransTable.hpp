@@ -0,0 +1,218 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+/////////////////////////////////
+// SharedTransTableData /////////
+/////////////////////////////////
+
+inline void SharedTransTableData::unpack(const unsigned long long & data)
+{
+  cost      = (int)(data & 0xFF);
+  costLimit = (int)((data >> 8) & 0xFF) - 1;
+  heuristic = (int)((data >> 16) & 0xFF);
+  priority  = (unsigned int)(data >> 24);
+}
+
+inline unsigned long long SharedTransTableData::pack() const
+{
+  return (unsigned long long)cost
+    | ((unsigned long long)(costLimit+1) << 8)
+    | ((unsigned long long)heuristic << 16)
+    | ((unsigned long long)priority << 24);
+}
+
+// Same as TransTableEntry::updateEntry.
+// returns true if entry was updated and the node must be expanded.
+// returns false if the node has been visited previously
+// and doesn't need expanding
+inline bool SharedTransTableData::updateEntry(const int & cost, const int & costLimit )
+{
+#ifdef USE_LAZY_TRANS_TABLE
+  if( cost > this->cost )
+  {
+    // Cost higher than cached state.  Prune node.
+    return false;
+  } else if ( cost == this->cost ) {
+    // Cost same as cache.
+    // Check if was reached on the current search iteration.
+    if ( costLimit == this->costLimit )
+    {
+      // Reached on this iteration (possibly by another thread).  Prune.
+      return false;
+    } else {
+      // reached on previous iteration.
+      // Update the cost, but do not prune.
+      this->costLimit = costLimit;
+      return true;
+    }
+  }
+#else
+  if( cost >= this->cost )
+  {
+    // Reached previously.  Prune.
+    return false;
+  }
+#endif
+  else
+  {
+    // cost is lower than the current entry.
+    this->cost = cost;
+    this->costLimit = costLimit;
+    return true;
+  }
+
+  return true;
+}
+
+/////////////////////////////////
+// SharedTransTable /////////////
+/////////////////////////////////
+
+// Only call this when no other thread is using the table.
+inline void SharedTransTable::reset()
+{
+  for( unsigned int i=0; i<size; i++)
+  {
+    transTable[i].check = 0;
+    transTable[i].data = 0;
+  }
+}
+
+inline unsigned int SharedTransTable::calculateIndex( const Hash & hash ) const
+{
+  return hash.value%size;
+}
+
+inline bool SharedTransTable::readEntry( const SharedTransTableEntry & entry, const unsigned long long & signature, SharedTransTableData & data ) const
+{
+  const unsigned long long packed = entry.data;
+  const unsigned long long check = entry.check;
+  if( packed == 0 || (check ^ packed) != signature )
+  {	// empty, another state, or torn by a concurrent write
+    return false;
+  }
+  data.unpack(packed);
+  return true;
+}
+
+inline void SharedTransTable::writeEntry( SharedTransTableEntry & entry, const unsigned long long & signature, const SharedTransTableData & data ) const
+{
+  const unsigned long long packed = data.pack();
+  entry.check = signature ^ packed;
+  entry.data = packed;
+}
+
+inline int SharedTransTable::getCachedHeuristic( const State & state, const Hash & hash ) const
+{
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  const SharedTransTableEntry & entry = transTable[calculateIndex(hash)];
+  SharedTransTableData data;
+  if( readEntry(entry, getSignature(state), data) )
+  {
+    return data.heuristic;
+  }
+#endif
+  return 0;
+}
+
+inline void SharedTransTable::updateCachedHeuristic( const State & state, const Hash & hash, const int & heur ) const
+{
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  SharedTransTableEntry & entry = transTable[calculateIndex(hash)];
+  const unsigned long long signature = getSignature(state);
+  SharedTransTableData data;
+  if( readEntry(entry, signature, data) && data.heuristic < heur )
+  {
+    data.heuristic = heur;
+    writeEntry(entry, signature, data);
+  }
+#endif
+}
+
+inline bool SharedTransTable::pruneState( const State & state, const Hash & hash, const int & heur, const int & cost, const int & costLimit, TransTableStats & stats )
+{
+  SharedTransTableEntry & entry = transTable[calculateIndex(hash)];
+  const unsigned long long signature = getSignature(state);
+#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
+  unsigned int priority = getPriority(hash);
+#endif
+  stats.probes++;
+
+  SharedTransTableData data;
+  if( readEntry(entry, signature, data) )
+  { // found the node
+    stats.hits++;
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+    bool modified = false;
+    if( data.heuristic < heur )
+    {
+      data.heuristic = heur;
+      modified = true;
+    }
+#endif
+
+    if( data.updateEntry( cost, costLimit ) )
+    {	// Needs updating
+      writeEntry(entry, signature, data);
+      return false;
+    }
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+    if( modified )
+    {
+      writeEntry(entry, signature, data);
+    }
+#endif
+    return true;
+
+  } else if ( entry.data == 0 ) {
+    // No node in the table at this location.
+    // Another thread may add a node here at the same time, the last write wins.
+    data.cost = cost;
+    data.costLimit = costLimit;
+#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
+    data.priority = priority;
+#endif
+    writeEntry(entry, signature, data);
+    return false;
+  }
+#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
+  else if ( priority > (unsigned int)(entry.data >> 24) )
+  {	// higher priority node-- just replace the entry
+    data.cost = cost;
+    data.costLimit = costLimit;
+    data.priority = priority;
+    writeEntry(entry, signature, data);
+  }
+#endif
+  // entry occupied by another state-- the node must be expanded.
+  return false;
+}
+
+inline long long SharedTransTable::numEntries() const
+{
+  long long fill = 0;
+  for( unsigned int i=0; i<size; i++) {
+    if( transTable[i].data != 0 ) {
+      fill++;
+    }
+  }
+  return fill;
+}
+
+inline double SharedTransTable::percentFull( ) const
+{
+  return (double)numEntries()/(double)size;
+}
+
+inline void SharedTransTable::printInfo(LogLevel level) const
+{
+  _LOG(level,"SharedTransTable: size=%u, entries=%12lli, fill=%f \n", size, numEntries(), percentFull());
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#ifdef USE_RUNTIME_TABLE_SIZE
+
+#ifndef TABLE_MEMORY_H
+#define TABLE_MEMORY_H
+
+#include "common.h"
+#include <stddef.h>
+
+// Memory budgets of the tables, in bytes.
+// Set these before the tables are constructed (main reads them from the command line).
+// Each trans table gets the whole budget, so a parallel search uses one per thread.
+size_t g_transTableBytes = (size_t)(DEFAULT_TT_MEGABYTES*1024*1024);
+size_t g_perimeterDbBytes = (size_t)(DEFAULT_PERIMETER_DB_MEGABYTES*1024*1024);
+
+// Largest power of two no larger than bytes/entrySize, and at least 1.
+// At most MAX_TABLE_ENTRIES, since the tables are indexed with the 32 bit Hash::value.
+const size_t MAX_TABLE_ENTRIES = (size_t)1 << 32;
+size_t tableEntries(const size_t bytes, const size_t entrySize);
+
+// An array of table entries that is mapped with transparent huge pages,
+// so that probes of a large table don't miss the TLB on every access.
+// The entries are constructed by NUM_THREADS threads, so that the pages
+// are spread over the memory of the cores that will use them.
+template<class Entry>
+class TableMemory
+{
+private:
+  Entry *   data;
+  size_t    count;
+  void *    mapping;
+  size_t    mappingBytes;
+
+public:
+  TableMemory() : data(NULL), count(0), mapping(NULL), mappingBytes(0) {}
+  ~TableMemory() { release(); }
+
+  // Maps and constructs count entries.  Exits if the memory isn't available.
+  // If construct is false, the entries are left zero filled and their pages
+  // are only touched when they are first written.
+  void allocate(const size_t count, const bool construct = true);
+  void release();
+  void swap(TableMemory & other);
+  // Uses count entries at offset bytes into an existing mapping (such as a mapped file)
+  // instead of allocating.  The mapping is unmapped by release.
+  void adopt(void * mapping, const size_t mappingBytes, const size_t offset, const size_t count);
+
+  size_t size() const { return count; }
+  Entry & operator[](const size_t index) const { return data[index]; }
+
+private:
+  struct TouchArg
+  {
+    TableMemory * self;
+    size_t        begin;
+    size_t        end;
+  };
+  static void * touch( void * arg );
+
+  // Not copyable
+  TableMemory(const TableMemory &);
+  TableMemory & operator=(const TableMemory &);
+};
+
+#include "tableMemory.hpp"
+
+#endif	// TABLE_MEMORY_H
+#endif	// USE_RUNTIME_TABLE_SIZE
@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2010-2012, Ken Anderson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#include <new>
+#include <algorithm>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+
+inline size_t tableEntries(const size_t bytes, const size_t entrySize)
+{
+  size_t entries = 1;
+  while( entries*2*entrySize <= bytes )
+  {
+    entries *= 2;
+  }
+  if( entries > MAX_TABLE_ENTRIES )
+  {
+    LOG_ERROR("Only %lu of the %lu entries can be indexed by the hash, using %lu bytes of the %lu\n",
+      (unsigned long)MAX_TABLE_ENTRIES, (unsigned long)entries,
+      (unsigned long)(MAX_TABLE_ENTRIES*entrySize), (unsigned long)bytes);
+    entries = MAX_TABLE_ENTRIES;
+  }
+  return entries;
+}
+
+template<class Entry>
+inline void TableMemory<Entry>::allocate(const size_t _count, const bool construct)
+{
+  release();
+  count = _count;
+
+  // Map an extra huge page so that the entries can start on a huge page boundary
+  const size_t bytes = count*sizeof(Entry);
+  mappingBytes = bytes + HUGE_PAGE_SIZE;
+  mapping = mmap(NULL, mappingBytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if( mapping == MAP_FAILED )
+  {
+    LOG_ERROR("Could not map %lu bytes for a table. exit(1)\n", (unsigned long)mappingBytes);
+    exit(1);
+  }
+  char * start = (char*)( ((size_t)mapping + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1) );
+#ifdef MADV_HUGEPAGE
+  // Only a hint.  The table still works if huge pages are disabled.
+  madvise(start, bytes, MADV_HUGEPAGE);
+#endif
+  data = (Entry*)start;
+  if( !construct )
+  {
+    return;
+  }
+
+  // First touch, in parallel
+  pthread_t threads[NUM_THREADS];
+  TouchArg args[NUM_THREADS];
+  for( int i=0; i<NUM_THREADS; i++ )
+  {
+    args[i].self = this;
+    args[i].begin = count*i/NUM_THREADS;
+    args[i].end = count*(i+1)/NUM_THREADS;
+    pthread_create(&threads[i], NULL, touch, &args[i]);
+  }
+  for( int i=0; i<NUM_THREADS; i++ )
+  {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+template<class Entry>
+void * TableMemory<Entry>::touch( void * arg )
+{
+  TouchArg * touchArg = (TouchArg*)arg;
+  Entry * data = touchArg->self->data;
+  for( size_t i=touchArg->begin; i<touchArg->end; i++ )
+  {
+    new (&data[i]) Entry();
+  }
+  return NULL;
+}
+
+// The entries only hold plain data, so they are not destructed
+template<class Entry>
+inline void TableMemory<Entry>::release()
+{
+  if( mapping )
+  {
+    munmap(mapping, mappingBytes);
+  }
+  data = NULL;
+  count = 0;
+  mapping = NULL;
+  mappingBytes = 0;
+}
+
+template<class Entry>
+inline void TableMemory<Entry>::adopt(void * _mapping, const size_t _mappingBytes, const size_t offset, const size_t _count)
+{
+  release();
+  mapping = _mapping;
+  mappingBytes = _mappingBytes;
+  data = (Entry*)( (char*)mapping + offset );
+  count = _count;
+}
+
+template<class Entry>
+inline void TableMemory<Entry>::swap(TableMemory & other)
+{
+  std::swap(data, other.data);
+  std::swap(count, other.count);
+  std::swap(mapping, other.mapping);
+  std::swap(mappingBytes, other.mappingBytes);
+}
@@ -16,13 +16,62 @@
 
 #include "common.h"
 #include "domain.h"
+#include "tableMemory.h"
 
-// TODO - could reduce the entry size if we only store something like (int)(state)%TT_SIZE
+// What a state is looked up by.
+// With USE_COMPACT_TRANS_TABLE, the signature is computed once per probe.
+struct TransTableKey
+{
+  const State * state;
+#ifdef USE_COMPACT_TRANS_TABLE
+  unsigned int  signature;
+#endif
 
+  TransTableKey()
+  : state(NULL)
+#ifdef USE_COMPACT_TRANS_TABLE
+  , signature(0)
+#endif
+  {}
+  TransTableKey(const State & _state)
+  : state(&_state)
+#ifdef USE_COMPACT_TRANS_TABLE
+  , signature( (unsigned int)(getSignature(_state) >> 32) )
+#endif
+  {}
+};
+
+#ifdef USE_COMPACT_TRANS_TABLE
+// Same interface as Heuristic, in one byte
+struct CompactHeuristic
+{
+  unsigned char value;
+};
+#endif
 
 class TransTableEntry {
 public:
   // Careful with the ordering!
+#ifdef USE_COMPACT_TRANS_TABLE
+  // Costs must be below 255 (MAX_COST)
+  unsigned int  signature;		// high half of getSignature(state), independent of the index
+  unsigned char cost;
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  CompactHeuristic heuristic;
+#endif
+#ifdef USE_LAZY_TRANS_TABLE
+  unsigned char costLimit;		// 255 until the state is reached
+#endif
+#ifdef USE_TT_EPOCH
+  unsigned char epoch;				// TransTable::epoch when the entry was written
+#endif
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+  unsigned char subtreeSize;	// bits in the number of nodes generated below the state on its last expansion
+#endif
+#ifdef USE_TT_SIGNATURE_CHECK
+  State   	    state;				// only kept to count the false signature matches
+#endif
+#else
   State   	    state;
   int           cost;
 #ifdef USE_TRANS_TABLE_HEUR_CACHING
@@ -31,6 +80,13 @@ public:
 #ifdef USE_LAZY_TRANS_TABLE
   int           costLimit;
 #endif
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+  unsigned int  subtreeSize;	// nodes generated below the state on its last expansion
+#endif
+#ifdef USE_TT_EPOCH
+  unsigned char epoch;				// TransTable::epoch when the entry was written
+#endif
+#endif
 #ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
   unsigned int  priority;
 #endif
@@ -39,30 +95,157 @@ public:
   TransTableEntry();
   void print(LogLevel level) const;
   bool updateEntry(const int & cost, const int & costLimit);
+  bool matches(const TransTableKey & key) const;
+  void set(const TransTableKey & key, const int & cost, const int & costLimit, const Hash & hash);
+#ifdef USE_TT_BUCKETS
+  bool isReplacedBefore(const TransTableEntry & other) const;
+#endif
 };
 
+#ifdef USE_TT_BUCKETS
+// The entries that a state can be stored in, starting on a cache line
+struct TransTableBucket
+{
+  TransTableEntry entries[TT_BUCKET_WAYS];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+#ifndef USE_RUNTIME_TABLE_SIZE
+const int TT_NUM_BUCKETS = (TT_SIZE + TT_BUCKET_WAYS - 1) / TT_BUCKET_WAYS;
+#endif
+#endif
+
+#ifdef USE_TT_L1
+// An entry of the front table.
+// Keeps the hash, to find the state's place in the main table when it is moved there.
+struct TransTableL1Entry
+{
+  TransTableEntry entry;
+  Hash            hash;
+};
+#endif
+
+// The entry of a state, looked up once per visit of the node
+// and used by all the trans table operations of that visit.
+// The state must not change while the handle is used.
+struct TransTableHandle
+{
+  TransTableKey     key;
+  Hash              hash;
+  TransTableEntry * entry;				// NULL if the state isn't in the table
+  unsigned int      version;			// TransTable::version when entry was found
+#ifdef USE_TT_L1
+  bool              foundInL1;
+#endif
+
+  TransTableHandle() : entry(NULL), version(0) {}
+  TransTableHandle(const State & state, const Hash & _hash) : key(state), hash(_hash), entry(NULL), version(0) {}
+};
+
+// Probe counters for a trans table.
+// Kept per searcher, so that threads sharing a table don't write to the same counters.
+struct TransTableStats
+{
+  long long     probes;		// calls to pruneState
+  long long     hits;			// ...that found the state in the table
+  long long     inserts;	// ...that stored the state in an empty entry
+  long long     replaces;	// ...that stored the state over another one
+#ifdef USE_TT_SIGNATURE_CHECK
+  long long     falsePositives;	// ...that matched the signature of a different state
+#endif
+#ifdef USE_TT_L1
+  long long     l1Hits;		// hits in the front table
+  long long     promotions;	// states moved from the main table to the front table
+  long long     demotions;	// states moved from the front table to the main table
+#endif
+
+  TransTableStats() { reset(); }
+  void reset()
+  {
+    probes = 0; hits = 0; inserts = 0; replaces = 0;
+#ifdef USE_TT_SIGNATURE_CHECK
+    falsePositives = 0;
+#endif
+#ifdef USE_TT_L1
+    l1Hits = 0; promotions = 0; demotions = 0;
+#endif
+  }
+#ifdef USE_TT_SIGNATURE_CHECK
+  double falsePositiveRate() const { return probes ? (double)falsePositives/(double)probes : 0.0; }
+#endif
+  double hitRate() const { return probes ? (double)hits/(double)probes : 0.0; }
+#ifdef USE_TT_L1
+  // Hits in each level, over the probes that reached that level
+  double l1HitRate() const { return probes ? (double)l1Hits/(double)probes : 0.0; }
+  double mainHitRate() const { return probes > l1Hits ? (double)(hits - l1Hits)/(double)(probes - l1Hits) : 0.0; }
+#endif
+};
 
 class TransTable
 {
 private:
+#if defined USE_RUNTIME_TABLE_SIZE && defined USE_TT_BUCKETS
+  TableMemory<TransTableBucket> buckets;
+  size_t indexMask;		// number of buckets - 1
+#elif defined USE_RUNTIME_TABLE_SIZE
+  TableMemory<TransTableEntry> transTable;
+  size_t indexMask;		// number of entries - 1
+#ifdef USE_TT_RESIZE
+  TableMemory<TransTableEntry> oldTable;	// the table being moved from, empty when not resizing
+  size_t oldIndexMask;
+  size_t migrated;					// entries of oldTable that have been moved
+  size_t maxEntries;				// largest table that fits in the budget along with the one it grows from
+  int numResizes;
+#endif
+#elif defined USE_TT_BUCKETS
+  TransTableBucket* buckets;
+#else
   TransTableEntry* transTable;
+#endif
+#ifdef USE_TT_L1
+  TransTableL1Entry * l1;		// the front table, TT_L1_SIZE entries
+#endif
+  long long numUsed;				// entries holding a state of the current search, in both tables
+  unsigned int version;			// changes whenever a state is written to, moved or removed from an entry
+#ifdef USE_TT_EPOCH
+  unsigned char epoch;
+#endif
+
+public:
+  TransTableStats stats;
 
 public:
-  TransTable() { transTable = new TransTableEntry[TT_SIZE]; }
-  ~TransTable() { delete[] transTable; }
+  TransTable();
+  ~TransTable();
+  // Empties the table and clears the stats, before a new search
   void reset();
+  // Empties the table, keeping the stats
+  void clear();
 
   // Adds or updates the state in the trans table,
   // and returns true if the node already exists and should be pruned from the search tree.
   // returns false if the state must be expanded.
   bool pruneState( const State & state, const Hash & hash, const int & heur, const int & cost, const int & costLimit );
 
+  // Finds the entry of the state, for a visit of the node
+  void lookup( TransTableHandle & handle );
+  // Same as pruneState, getCachedHeuristic and updateCachedHeuristic, through the entry found by lookup
+  bool pruneState( TransTableHandle & handle, const int & heur, const int & cost, const int & costLimit );
+  int getCachedHeuristic( TransTableHandle & handle ) const;
+  void updateCachedHeuristic( TransTableHandle & handle, const int & heuristic ) const;
+
   // Returns the cached heuristic value, if the state exists in the table
   // returns 0 otherwise
  // int getCachedHeuristic( const State & state, const Hash & hash ) const;
   int getCachedHeuristic( const State & state, const Hash & hash) const;
   // updates the cached heuristic value if it is large enough
   void updateCachedHeuristic( const State & state, const Hash & hash, const int & heuristic ) const;
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+  // Records the number of nodes generated below an expanded state
+  void updateSubtreeSize( const State & state, const Hash & hash, const long long & subtreeSize ) const;
+#endif
+
+  // Starts loading the entries of the state into the cache
+  void prefetch( const Hash & hash ) const;
 
   // Stats
   void print(LogLevel level) const;
@@ -70,9 +253,40 @@ public:
   double percentFull( ) const;
 
 private:
-  TransTableEntry &getEntry(const unsigned index);
+  TransTableEntry &getEntry(const size_t index) const;
   long long numEntries( ) const;
+  size_t capacity( ) const;
+  // returns true if the entry holds a state of the current search
+  bool isUsed( const TransTableEntry & entry ) const;
+
+  // Not copyable
+  TransTable(const TransTable &);
+  TransTable & operator=(const TransTable &);
   unsigned int calculateIndex( const Hash & hash ) const;
+  // Returns the entry holding the state, or NULL if it isn't in the table
+  TransTableEntry * findEntry( const TransTableKey & key, const Hash & hash ) const;
+  // Returns the entry of the handle if no state was moved since it was found,
+  // and otherwise looks the state up again
+  TransTableEntry * handleEntry( TransTableHandle & handle ) const;
+  // Same as findEntry, in the main table only
+  TransTableEntry * findMainEntry( const TransTableKey & key, const Hash & hash ) const;
+  // Returns the entry that a new state should be written to, or NULL to not store it
+  TransTableEntry * replacementEntry( const Hash & hash ) const;
+#ifdef USE_TT_RESIZE
+  // Replaces the table with one twice the size, and starts moving the entries over
+  void grow();
+  // Moves the next TT_RESIZE_STEP entries of the old table
+  void migrate();
+#endif
+#ifdef USE_TT_L1
+  unsigned int calculateL1Index( const Hash & hash ) const;
+  TransTableEntry * findL1Entry( const TransTableKey & key, const Hash & hash ) const;
+  // Writes the entry into the front table, and moves the state it displaces to the main table.
+  // Returns the entry in the front table.
+  TransTableEntry * moveToL1( const TransTableEntry & entry, const Hash & hash );
+  // Stores a state displaced from the front table in the main table, if the policy lets it
+  void demote( const TransTableL1Entry & victim );
+#endif
 };
 
 // Inline function definintions
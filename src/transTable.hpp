@@ -14,38 +14,405 @@
 /////////////////////////////////
 
 TransTableEntry::TransTableEntry()
-: cost(MAX_COST)
+:
+#ifdef USE_COMPACT_TRANS_TABLE
+  signature(0),
+#endif
+  cost(MAX_COST)
 #ifdef USE_LAZY_TRANS_TABLE
 , costLimit(-1)
 #endif
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+, subtreeSize(0)
+#endif
+#ifdef USE_TT_EPOCH
+, epoch(0)
+#endif
 {
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  heuristic.value = 0;
+#endif
 }
 
-inline TransTableEntry &TransTable::getEntry(const unsigned index)
+inline bool TransTableEntry::matches(const TransTableKey & key) const
 {
-  return transTable[index];
+#ifdef USE_COMPACT_TRANS_TABLE
+  return this->signature == key.signature;
+#else
+  return this->state == *key.state;
+#endif
+}
+
+inline void TransTableEntry::set(const TransTableKey & key, const int & cost, const int & costLimit, const Hash & hash)
+{
+#ifdef USE_COMPACT_TRANS_TABLE
+  this->signature = key.signature;
+#ifdef USE_TT_SIGNATURE_CHECK
+  this->state = *key.state;
+#endif
+#else
+  this->state = *key.state;
+#endif
+  this->cost = cost;
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  // Don't keep the cached heuristic of the state that was replaced
+  this->heuristic.value = 0;
+#endif
+#ifdef USE_LAZY_TRANS_TABLE
+  this->costLimit = costLimit;
+#endif
+#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
+  this->priority = getPriority(hash);
+#endif
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+  this->subtreeSize = 0;
+#endif
+}
+
+#ifdef USE_TT_BUCKETS
+// returns true if this entry should be replaced before the other one
+inline bool TransTableEntry::isReplacedBefore(const TransTableEntry & other) const
+{
+#if defined USE_TT_REPLACE_AGE
+  return this->costLimit < other.costLimit
+    || ( this->costLimit == other.costLimit && this->cost > other.cost );
+#elif defined USE_TT_REPLACE_COST
+  return this->cost > other.cost;
+#elif defined USE_TT_REPLACE_SUBTREE
+  return this->subtreeSize < other.subtreeSize
+    || ( this->subtreeSize == other.subtreeSize && this->cost > other.cost );
+#endif
 }
+#endif
 
 /////////////////////////////////
 // TransTable ///////////////////
 /////////////////////////////////
 
+inline TransTable::TransTable()
+: numUsed(0)
+, version(0)
+#ifdef USE_TT_EPOCH
+, epoch(1)
+#endif
+{
+#if defined USE_RUNTIME_TABLE_SIZE && defined USE_TT_BUCKETS
+  buckets.allocate( tableEntries(g_transTableBytes, sizeof(TransTableBucket)) );
+  indexMask = buckets.size() - 1;
+#elif defined USE_RUNTIME_TABLE_SIZE && defined USE_TT_RESIZE
+  const size_t initialBytes = std::min( g_transTableBytes, (size_t)(TT_RESIZE_INITIAL_MEGABYTES*1024*1024) );
+  transTable.allocate( tableEntries(initialBytes, sizeof(TransTableEntry)) );
+  indexMask = transTable.size() - 1;
+  oldIndexMask = 0;
+  migrated = 0;
+  // The old table is half the size of the new one
+  maxEntries = tableEntries(g_transTableBytes/3*2, sizeof(TransTableEntry));
+  numResizes = 0;
+#elif defined USE_RUNTIME_TABLE_SIZE
+  transTable.allocate( tableEntries(g_transTableBytes, sizeof(TransTableEntry)) );
+  indexMask = transTable.size() - 1;
+#elif defined USE_TT_BUCKETS
+  buckets = new TransTableBucket[TT_NUM_BUCKETS];
+#else
+  transTable = new TransTableEntry[TT_SIZE];
+#endif
+#ifdef USE_TT_L1
+  l1 = new TransTableL1Entry[TT_L1_SIZE];
+#endif
+}
+
+inline TransTable::~TransTable()
+{
+#ifndef USE_RUNTIME_TABLE_SIZE
+#ifdef USE_TT_BUCKETS
+  delete[] buckets;
+#else
+  delete[] transTable;
+#endif
+#endif
+#ifdef USE_TT_L1
+  delete[] l1;
+#endif
+}
+
+inline TransTableEntry &TransTable::getEntry(const size_t index) const
+{
+#ifdef USE_TT_BUCKETS
+  return buckets[index/TT_BUCKET_WAYS].entries[index%TT_BUCKET_WAYS];
+#else
+  return transTable[index];
+#endif
+}
+
+inline size_t TransTable::capacity() const
+{
+#if defined USE_RUNTIME_TABLE_SIZE && defined USE_TT_BUCKETS
+  return (indexMask + 1)*TT_BUCKET_WAYS;
+#elif defined USE_RUNTIME_TABLE_SIZE
+  return indexMask + 1;
+#elif defined USE_TT_BUCKETS
+  return TT_NUM_BUCKETS*TT_BUCKET_WAYS;
+#else
+  return TT_SIZE;
+#endif
+}
+
 // Use this function if you want to initialize the TT as well.
 inline void TransTable::reset()
 {
+  clear();
+  stats.reset();
+}
+
+inline void TransTable::clear()
+{
+  numUsed = 0;
+  version++;
+#ifdef USE_TT_RESIZE
+  // The states left in the old table are from the search that ended
+  oldTable.release();
+#endif
+#ifdef USE_TT_EPOCH
+  // Entries of older epochs count as empty.
+  // Only clear them when the epoch wraps around.
+  if( ++epoch != 0 )
+  {
+    return;
+  }
+  epoch = 1;
+#endif
   TransTableEntry entry;
-  for( int i=0; i<TT_SIZE; i++)
+  for( size_t i=0; i<capacity(); i++)
+  {
+    getEntry(i) = entry;
+  }
+#ifdef USE_TT_L1
+  for( int i=0; i<TT_L1_SIZE; i++)
   {
-    transTable[i] = entry;
+    l1[i].entry = entry;
   }
+#endif
   //memset( transTable, 0, sizeof(SearchState)*TT_SIZE );
 }
 
+inline bool TransTable::isUsed( const TransTableEntry & entry ) const
+{
+#ifdef USE_TT_EPOCH
+  return entry.cost != MAX_COST && entry.epoch == epoch;
+#else
+  return entry.cost != MAX_COST;
+#endif
+}
+
+// returns the index of the entry, or of the bucket with USE_TT_BUCKETS
 inline unsigned int TransTable::calculateIndex( const Hash & hash ) const
 {
+#if defined USE_RUNTIME_TABLE_SIZE
+  // The bits of the Zobrist hash are uniform, so the low ones make a good index
+  return hash.value & indexMask;
+#elif defined USE_TT_BUCKETS
+  return hash.value%TT_NUM_BUCKETS;
+#else
   return hash.value%TT_SIZE;
+#endif
+}
+
+inline void TransTable::prefetch( const Hash & hash ) const
+{
+#ifdef USE_TT_L1
+  __builtin_prefetch( &l1[calculateL1Index(hash)] );
+#endif
+#ifdef USE_TT_BUCKETS
+  __builtin_prefetch( &buckets[calculateIndex(hash)] );
+#else
+  __builtin_prefetch( &transTable[calculateIndex(hash)] );
+#endif
+}
+
+inline TransTableEntry * TransTable::findEntry( const TransTableKey & key, const Hash & hash ) const
+{
+#ifdef USE_TT_L1
+  TransTableEntry * entry = findL1Entry(key, hash);
+  if( entry )
+  {
+    return entry;
+  }
+#endif
+  return findMainEntry(key, hash);
 }
 
+inline TransTableEntry * TransTable::findMainEntry( const TransTableKey & key, const Hash & hash ) const
+{
+  unsigned int index = calculateIndex(hash);
+#ifdef USE_TT_BUCKETS
+  TransTableBucket & bucket = buckets[index];
+  for( int i=0; i<TT_BUCKET_WAYS; i++ )
+  {
+    TransTableEntry & entry = bucket.entries[i];
+    if( isUsed(entry) && entry.matches(key) )
+    {
+      return &entry;
+    }
+  }
+#else
+  TransTableEntry & entry = transTable[index];
+  if( isUsed(entry) && entry.matches(key) )
+  {
+    return &entry;
+  }
+#endif
+#ifdef USE_TT_RESIZE
+  // The state may not have been moved yet
+  if( oldTable.size() )
+  {
+    const unsigned int oldIndex = hash.value & oldIndexMask;
+    TransTableEntry & oldEntry = oldTable[oldIndex];
+    if( oldIndex >= migrated && isUsed(oldEntry) && oldEntry.matches(key) )
+    {
+      return &oldEntry;
+    }
+  }
+#endif
+  return NULL;
+}
+
+inline TransTableEntry * TransTable::replacementEntry( const Hash & hash ) const
+{
+  unsigned int index = calculateIndex(hash);
+#ifdef USE_TT_BUCKETS
+  // Take an empty entry if there is one, otherwise the one the policy values least.
+  TransTableBucket & bucket = buckets[index];
+  TransTableEntry * victim = &bucket.entries[0];
+  for( int i=0; i<TT_BUCKET_WAYS; i++ )
+  {
+    TransTableEntry & entry = bucket.entries[i];
+    if( !isUsed(entry) )
+    {
+      return &entry;
+    }
+    if( entry.isReplacedBefore(*victim) )
+    {
+      victim = &entry;
+    }
+  }
+  // The new state always goes in. It hasn't been expanded yet, so comparing
+  // it with the victim would favour the states stored first.
+  return victim;
+#else
+  TransTableEntry & entry = transTable[index];
+  if( !isUsed(entry) )
+  {	// No node in the table at this location.
+    return &entry;
+  }
+#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
+  if( getPriority(hash) > entry.priority )
+  {	// higher priority node-- just replace the entry
+    return &entry;
+  }
+#endif
+  // entry occupied by another state
+  return NULL;
+#endif
+}
+
+#ifdef USE_TT_L1
+inline unsigned int TransTable::calculateL1Index( const Hash & hash ) const
+{
+  // The high bits, so that the states sharing an L1 entry don't all share a main table entry too
+  return (hash.value >> 16) & (TT_L1_SIZE - 1);
+}
+
+inline TransTableEntry * TransTable::findL1Entry( const TransTableKey & key, const Hash & hash ) const
+{
+  TransTableEntry & entry = l1[calculateL1Index(hash)].entry;
+  if( isUsed(entry) && entry.matches(key) )
+  {
+    return &entry;
+  }
+  return NULL;
+}
+
+inline TransTableEntry * TransTable::moveToL1( const TransTableEntry & entry, const Hash & hash )
+{
+  TransTableL1Entry & slot = l1[calculateL1Index(hash)];
+  const TransTableL1Entry victim = slot;
+  slot.entry = entry;
+  slot.hash = hash;
+  version++;
+  if( isUsed(victim.entry) )
+  {
+    demote(victim);
+  }
+  return &slot.entry;
+}
+
+inline void TransTable::demote( const TransTableL1Entry & victim )
+{
+  stats.demotions++;
+  TransTableEntry * entry = replacementEntry(victim.hash);
+  if( !entry )
+  {	// The main table keeps its state, and the victim is lost
+    numUsed--;
+    return;
+  }
+  if( isUsed(*entry) )
+  {
+    stats.replaces++;
+    numUsed--;
+  }
+  *entry = victim.entry;
+}
+#endif
+
+#ifdef USE_TT_RESIZE
+inline void TransTable::grow()
+{
+  oldTable.swap(transTable);
+  oldIndexMask = indexMask;
+  migrated = 0;
+  version++;
+#ifdef USE_TT_EPOCH
+  // Zero filled entries have epoch 0, which is never the current epoch,
+  // so the new table doesn't need to be constructed.
+  transTable.allocate( oldTable.size()*2, false );
+#else
+  transTable.allocate( oldTable.size()*2 );
+#endif
+  indexMask = transTable.size() - 1;
+  numResizes++;
+}
+
+inline void TransTable::migrate()
+{
+  version++;
+  for( int i=0; i<TT_RESIZE_STEP && migrated < oldTable.size(); i++, migrated++ )
+  {
+    const TransTableEntry & entry = oldTable[migrated];
+    if( !isUsed(entry) )
+    {
+      continue;
+    }
+    Hash hash;
+    hash.calculateHash(entry.state);
+    TransTableEntry * newEntry = replacementEntry(hash);
+    if( !newEntry )
+    {	// A state added since the resize holds the entry
+      numUsed--;
+      continue;
+    }
+    if( isUsed(*newEntry) )
+    {
+      numUsed--;
+    }
+    *newEntry = entry;
+  }
+  if( migrated == oldTable.size() )
+  {
+    oldTable.release();
+  }
+}
+#endif
+
 // Updates the entry if needed.
 // returns true if entry was updated and the node must be expanded.
 // returns false if the node has been visited previously
@@ -104,56 +471,156 @@ inline bool TransTableEntry::updateEntry(const int & cost, const int & costLimit
 inline int TransTable::getCachedHeuristic( const State & state, const Hash & hash ) const
 {
 #ifdef USE_TRANS_TABLE_HEUR_CACHING
-  // Calculate index and lookup entry
-  unsigned int index = calculateIndex(hash);
-  TransTableEntry & entry = transTable[index];
-
-  if( entry.state == state )
+  const TransTableEntry * entry = findEntry(TransTableKey(state), hash);
+  if( entry )
   { // found the node
     //LOG("perimeter heuristic value=%i\n",entry.cost);
-    return entry.heuristic.value;
+    return entry->heuristic.value;
   }
 #endif
   return 0;
 }
 
-// TODO- potential optimization-- only lookup once.  But update a couple times.
 inline void TransTable::updateCachedHeuristic( const State & state, const Hash & hash, const int & heur ) const
 {
 #ifdef USE_TRANS_TABLE_HEUR_CACHING
-  // Calculate index and lookup entry
-  unsigned int index = calculateIndex(hash);
-  TransTableEntry & entry = transTable[index];
-
-  if( entry.state == state )
+  TransTableEntry * entry = findEntry(TransTableKey(state), hash);
+  if( entry )
   { // found the node
     //LOG("perimeter heuristic value=%i\n",entry.cost);
-    entry.heuristic.value = std::max(entry.heuristic.value, heur);
+    entry->heuristic.value = std::max((int)entry->heuristic.value, heur);
+  }
+#endif
+}
+
+#if defined USE_TT_BUCKETS && defined USE_TT_REPLACE_SUBTREE
+inline void TransTable::updateSubtreeSize( const State & state, const Hash & hash, const long long & subtreeSize ) const
+{
+  TransTableEntry * entry = findEntry(TransTableKey(state), hash);
+  if( entry )
+  {
+#ifdef USE_COMPACT_TRANS_TABLE
+    unsigned char bits = 0;
+    for( long long size = subtreeSize; size; size >>= 1 )
+    {
+      bits++;
+    }
+    entry->subtreeSize = bits;
+#else
+    entry->subtreeSize = (unsigned int)std::min(subtreeSize, 0xFFFFFFFFLL);
+#endif
+  }
+}
+#endif
+
+inline void TransTable::lookup( TransTableHandle & handle )
+{
+#ifdef USE_TT_RESIZE
+  if( oldTable.size() )
+  {
+    migrate();
+  }
+  else if( numUsed > TT_RESIZE_LOAD*capacity() && capacity() < maxEntries )
+  {
+    grow();
+  }
+#endif
+#ifdef USE_TT_L1
+  handle.entry = findL1Entry(handle.key, handle.hash);
+  handle.foundInL1 = (handle.entry != NULL);
+  if( !handle.entry && (handle.entry = findMainEntry(handle.key, handle.hash)) )
+  {	// Bring the state to the front, and free its entry in the main table
+    const TransTableEntry promoted = *handle.entry;
+    *handle.entry = TransTableEntry();
+    version++;
+    handle.entry = moveToL1(promoted, handle.hash);
+    stats.promotions++;
+  }
+#else
+  handle.entry = findEntry(handle.key, handle.hash);
+#endif
+  handle.version = version;
+}
+
+inline TransTableEntry * TransTable::handleEntry( TransTableHandle & handle ) const
+{
+  if( handle.version == version )
+  {	// No state was written or moved since the lookup
+    return handle.entry;
+  }
+#ifndef USE_TT_RESIZE
+  // The entry may still hold the state.
+  // With USE_TT_RESIZE it may be in a table that was released.
+  if( handle.entry && isUsed(*handle.entry) && handle.entry->matches(handle.key) )
+  {
+    return handle.entry;
+  }
+#endif
+  handle.entry = findEntry(handle.key, handle.hash);
+  handle.version = version;
+  return handle.entry;
+}
+
+inline int TransTable::getCachedHeuristic( TransTableHandle & handle ) const
+{
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  const TransTableEntry * entry = handleEntry(handle);
+  if( entry )
+  {
+    return entry->heuristic.value;
+  }
+#endif
+  return 0;
+}
+
+inline void TransTable::updateCachedHeuristic( TransTableHandle & handle, const int & heur ) const
+{
+#ifdef USE_TRANS_TABLE_HEUR_CACHING
+  TransTableEntry * entry = handleEntry(handle);
+  if( entry )
+  {
+    entry->heuristic.value = std::max((int)entry->heuristic.value, heur);
   }
 #endif
 }
 
 inline bool TransTable::pruneState( const State & state, const Hash & hash, const int & heur, const int & cost, const int & costLimit )
 {
-  // Calculate index and lookup entry
-  unsigned int index = calculateIndex(hash);
-  TransTableEntry & entry = transTable[index];
+  TransTableHandle handle(state, hash);
+  lookup(handle);
+  return pruneState(handle, heur, cost, costLimit);
+}
+
+inline bool TransTable::pruneState( TransTableHandle & handle, const int & heur, const int & cost, const int & costLimit )
+{
   //LOG("looked at TT: hash=%x index=%i\n", state.hash, index);
-#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
-  unsigned int priority = getPriority(hash);
-#endif
+  stats.probes++;
+  TransTableEntry * entry = handleEntry(handle);
 
-  if( entry.state == state )
+  if( entry )
   { // found the node
+    stats.hits++;
+#ifdef USE_TT_L1
+    if( handle.foundInL1 )
+    {
+      stats.l1Hits++;
+    }
+#endif
+#ifdef USE_TT_SIGNATURE_CHECK
+    if( !(entry->state == *handle.key.state) )
+    {
+      stats.falsePositives++;
+    }
+#endif
 #ifdef USE_TRANS_TABLE_HEUR_CACHING
-    if( entry.heuristic.value < heur )
+    if( entry->heuristic.value < heur )
     {
-      entry.heuristic.value = heur;
+      entry->heuristic.value = heur;
     }
 #endif
 
     // Check whether an update is required
-    if( entry.updateEntry( cost, costLimit ) )
+    if( entry->updateEntry( cost, costLimit ) )
     {	// Needs updating
       return false;
     }
@@ -161,58 +628,67 @@ inline bool TransTable::pruneState( const State & state, const Hash & hash, cons
     { // does not need updating
       return true;
     }
-
-  // No node in the table at this location.
-  // So just add the node in.
-  } else if ( entry.cost == MAX_COST ) {
-    // Did not find the state.
-    // Add the state if there is not an entry already there.
-    //LOG("Adding state to TT\n");
-    entry.state = state;
-    entry.cost = cost;
-#ifdef USE_LAZY_TRANS_TABLE
-    entry.costLimit = costLimit;
-#endif
-#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
-    entry.priority = priority;
-#endif
-    return false;
   }
-#ifdef USE_TRANS_TABLE_STATE_PRIORITIZATION
-  else if ( priority > entry.priority )
-  {	// higher priority node-- just replace the entry
-    entry.state = state;
-    entry.cost = cost;
-#ifdef USE_LAZY_TRANS_TABLE
-    entry.costLimit = costLimit;
+
+  // Did not find the state.
+  // Add it if there is an empty entry, or if it wins over the state already there.
+  TransTableEntry candidate;
+  candidate.set(handle.key, cost, costLimit, handle.hash);
+#ifdef USE_TT_EPOCH
+  candidate.epoch = epoch;
 #endif
-    entry.priority = priority;
+#ifdef USE_TT_L1
+  // Always goes to the front table
+  stats.inserts++;
+  numUsed++;
+  handle.entry = moveToL1(candidate, handle.hash);
+#else
+  entry = replacementEntry(handle.hash);
+  if( entry )
+  {
+    //LOG("Adding state to TT\n");
+    if( isUsed(*entry) )
+    {
+      stats.replaces++;
+    }
+    else
+    {
+      stats.inserts++;
+      numUsed++;
+    }
+    *entry = candidate;
+    version++;
+    handle.entry = entry;
   }
 #endif
-  // entry occupied by another state-- the state isn't actually updated, but we say it is because it must be expanded.
+  handle.version = version;
+  // Whether it was added or not, the state must be expanded.
   return false;
 }
 
+// Counted as the entries are written, so this doesn't scan the table
 inline long long TransTable::numEntries() const
 {
-  long long fill = 0;
-  for(int i=0; i<TT_SIZE; i++) {
-    if( transTable[i].cost != MAX_COST ) {
-      fill++;
-    }
-  }
-  return fill;
+  return numUsed;
 }
 
 inline double TransTable::percentFull( ) const
 {
   long long fill = numEntries( );
-  return (double)fill/(double)TT_SIZE;
+#ifdef USE_TT_L1
+  return (double)fill/(double)(capacity() + TT_L1_SIZE);
+#else
+  return (double)fill/(double)capacity();
+#endif
 }
 
 inline void TransTableEntry::print(LogLevel level ) const
 {
+#ifdef USE_COMPACT_TRANS_TABLE
+  _LOG(level,"signature=%08x", this->signature );
+#else
   this->state.print(level);
+#endif
   _LOG(level," cost=%i", this->cost );
 #ifdef USE_LAZY_TRANS_TABLE
   _LOG(level," costLim=%i", this->costLimit );
@@ -223,18 +699,40 @@ inline void TransTableEntry::print(LogLevel level ) const
 inline void TransTable::print(LogLevel level) const
 {
   _LOG(level,"TransTable= [\n");
-  for( int i=0; i<TT_SIZE; i++ )
+  for( size_t i=0; i<capacity(); i++ )
   {
-    const TransTableEntry & entry = transTable[i];
-    if( entry.cost != MAX_COST )
+    const TransTableEntry & entry = getEntry(i);
+    if( isUsed(entry) )
     {
       entry.print(level);
     }
   }
+#ifdef USE_TT_L1
+  _LOG(level,"L1= [\n");
+  for( int i=0; i<TT_L1_SIZE; i++ )
+  {
+    if( isUsed(l1[i].entry) )
+    {
+      l1[i].entry.print(level);
+    }
+  }
+  _LOG(level,"]\n");
+#endif
   _LOG(level,"]\n");
 }
 
 inline void TransTable::printInfo(LogLevel level) const
 {
-  _LOG(level,"TransTable: size=%i, entries=%12lli, fill=%f \n", TT_SIZE, numEntries(), percentFull());
+  _LOG(level,"TransTable: size=%lu, entries=%12lli, fill=%f hitRate=%f inserts=%lli replaces=%lli ", (unsigned long)capacity(), numEntries(), percentFull(), stats.hitRate(), stats.inserts, stats.replaces);
+#ifdef USE_TT_RESIZE
+  _LOG(level,"resizes=%i maxSize=%lu ", numResizes, (unsigned long)maxEntries);
+#endif
+#ifdef USE_TT_SIGNATURE_CHECK
+  _LOG(level,"falsePositives=%lli rate=%g ", stats.falsePositives, stats.falsePositiveRate());
+#endif
+#ifdef USE_TT_L1
+  _LOG(level,"l1Size=%i l1HitRate=%f mainHitRate=%f promotions=%lli demotions=%lli ",
+    TT_L1_SIZE, stats.l1HitRate(), stats.mainHitRate(), stats.promotions, stats.demotions);
+#endif
+  _LOG(level,"\n");
 }